@@ -31,7 +31,8 @@ protected:
 			std::forward<Request>(request)
 		).toDC(
 			dcId ? MTP::ShiftDcId(dcId, MTP::kStatsDcShift) : 0
-		).overrideId(id));
+		).overrideId(id
+		).priority(MTP::RequestPriority::Prefetch));
 	}
 
 	[[nodiscard]] MTP::Sender &api();
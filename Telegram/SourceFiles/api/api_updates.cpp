@@ -81,6 +81,11 @@ constexpr auto kNoUpdatesTimeout = 60 * 1000;
 // If nothing is received in 1 min when was a sleepmode we ping.
 constexpr auto kNoUpdatesAfterSleepTimeout = 60 * crl::time(1000);
 
+// Apply a large difference in parts, giving the event loop a turn
+// after each part, so that catching up after sleep won't freeze the app.
+constexpr auto kDifferencePartDuration = crl::time(8);
+constexpr auto kDifferenceMessagesStep = 16;
+
 enum class DataIsLoadedResult {
 	NotLoaded = 0,
 	FromNotLoaded = 1,
@@ -483,23 +488,23 @@ void Updates::differenceDone(const MTPupdates_Difference &result) {
 	} break;
 	case mtpc_updates_differenceSlice: {
 		auto &d = result.c_updates_differenceSlice();
-		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates());
-
-		auto &s = d.vintermediate_state().c_updates_state();
-		setState(s.vpts().v, s.vdate().v, s.vqts().v, s.vseq().v);
-
-		_ptsWaiter.setRequesting(false);
-
-		MTP_LOG(0, ("getDifference "
-			"{ good - after a slice of difference was received }%1"
-			).arg(_session->mtp().isTestMode() ? " TESTMODE" : ""));
-		getDifference();
+		feedDifference(
+			d.vusers(),
+			d.vchats(),
+			d.vnew_messages(),
+			d.vother_updates(),
+			d.vintermediate_state(),
+			true);
 	} break;
 	case mtpc_updates_difference: {
 		auto &d = result.c_updates_difference();
-		feedDifference(d.vusers(), d.vchats(), d.vnew_messages(), d.vother_updates());
-
-		stateDone(d.vstate());
+		feedDifference(
+			d.vusers(),
+			d.vchats(),
+			d.vnew_messages(),
+			d.vother_updates(),
+			d.vstate(),
+			false);
 	} break;
 	case mtpc_updates_differenceTooLong: {
 		LOG(("API Error: updates.differenceTooLong is not supported by Telegram Desktop!"));
@@ -596,13 +601,103 @@ void Updates::feedDifference(
 		const MTPVector<MTPUser> &users,
 		const MTPVector<MTPChat> &chats,
 		const MTPVector<MTPMessage> &msgs,
-		const MTPVector<MTPUpdate> &other) {
+		const MTPVector<MTPUpdate> &other,
+		const MTPupdates_State &state,
+		bool slice) {
+	Expects(!_pendingDifference);
+
 	Core::App().checkAutoLock();
 	session().data().processUsers(users);
 	session().data().processChats(chats);
 	feedMessageIds(other);
-	session().data().processMessages(msgs, NewMessageType::Unread);
-	feedUpdateVector(other, SkipUpdatePolicy::SkipMessageIds);
+
+	// We stay in the requesting state until the last part is applied,
+	// so that new updates wait for the next difference and pts order holds.
+	_pendingDifference = std::make_unique<PendingDifference>(
+		PendingDifference{
+			.messages = msgs.v,
+			.updates = other.v,
+			.state = state,
+			.slice = slice,
+		});
+	auto &messages = _pendingDifference->messages;
+	ranges::stable_sort(messages, ranges::less(), [](const MTPMessage &m) {
+		return uint32(IdFromMessage(m).bare); // Only 32 bit values here.
+	});
+	auto &updates = _pendingDifference->updates;
+	const auto removed = ranges::remove(
+		updates,
+		mtpc_updateMessageID,
+		&MTPUpdate::type);
+	updates.erase(removed, end(updates));
+	ranges::stable_sort(updates, ranges::less(), [](const MTPUpdate &u) {
+		return (u.type() == mtpc_updateGroupCallParticipants) ? 0 : 1;
+	});
+	feedDifferencePart();
+}
+
+void Updates::feedDifferencePart() {
+	const auto pending = _pendingDifference.get();
+	if (!pending) {
+		return;
+	}
+	const auto till = crl::now() + kDifferencePartDuration;
+	const auto &messages = pending->messages;
+	while (pending->messagesApplied < messages.size()
+		&& crl::now() < till) {
+		const auto from = pending->messagesApplied;
+		const auto count = std::min(
+			int(messages.size()) - from,
+			kDifferenceMessagesStep);
+		pending->messagesApplied += count;
+		session().data().processMessages(
+			messages.mid(from, count),
+			NewMessageType::Unread);
+	}
+	const auto &updates = pending->updates;
+	while (pending->messagesApplied == messages.size()
+		&& pending->updatesApplied < updates.size()
+		&& crl::now() < till) {
+		feedUpdate(updates[pending->updatesApplied++]);
+	}
+	session().data().sendHistoryChangeNotifications();
+
+	const auto total = int(messages.size() + updates.size());
+	const auto processed = pending->messagesApplied
+		+ pending->updatesApplied;
+	if (processed < total) {
+		_differenceProgress = DifferenceProgress{ processed, total };
+		crl::on_main(&session(), [=] {
+			feedDifferencePart();
+		});
+		return;
+	}
+	const auto finished = base::take(_pendingDifference);
+	_differenceProgress = DifferenceProgress();
+	differenceApplied(finished->state, finished->slice);
+}
+
+void Updates::differenceApplied(
+		const MTPupdates_State &state,
+		bool slice) {
+	if (!slice) {
+		stateDone(state);
+		return;
+	}
+	const auto &s = state.c_updates_state();
+	setState(s.vpts().v, s.vdate().v, s.vqts().v, s.vseq().v);
+
+	_ptsWaiter.setRequesting(false);
+
+	MTP_LOG(0, ("getDifference "
+		"{ good - after a slice of difference was received }%1"
+		).arg(_session->mtp().isTestMode() ? " TESTMODE" : ""));
+	getDifference();
+}
+
+auto Updates::differenceProgress() const
+-> rpl::producer<DifferenceProgress> {
+	return _differenceProgress.value();
 }
 
 void Updates::differenceFail(const MTP::Error &error) {
@@ -62,6 +62,17 @@ public:
 	void getDifference();
 	void requestChannelRangeDifference(not_null<History*> history);
 
+	struct DifferenceProgress {
+		int processed = 0;
+		int total = 0;
+
+		friend inline bool operator==(
+			const DifferenceProgress &,
+			const DifferenceProgress &) = default;
+	};
+	// Large differences are applied in parts, this tells how far it got.
+	[[nodiscard]] rpl::producer<DifferenceProgress> differenceProgress() const;
+
 	void addActiveChat(rpl::producer<PeerData*> chat);
 
 private:
@@ -82,6 +93,15 @@ private:
 		rpl::lifetime lifetime;
 	};
 
+	struct PendingDifference {
+		QVector<MTPMessage> messages;
+		QVector<MTPUpdate> updates;
+		MTPupdates_State state;
+		bool slice = false;
+		int messagesApplied = 0;
+		int updatesApplied = 0;
+	};
+
 	void channelRangeDifferenceSend(
 		not_null<ChannelData*> channel,
 		MsgRange range,
@@ -108,7 +128,11 @@ private:
 		const MTPVector<MTPUser> &users,
 		const MTPVector<MTPChat> &chats,
 		const MTPVector<MTPMessage> &msgs,
-		const MTPVector<MTPUpdate> &other);
+		const MTPVector<MTPUpdate> &other,
+		const MTPupdates_State &state,
+		bool slice);
+	void feedDifferencePart();
+	void differenceApplied(const MTPupdates_State &state, bool slice);
 	void stateDone(const MTPupdates_State &state);
 	void setState(int32 pts, int32 date, int32 qts, int32 seq);
 	void channelDifferenceDone(
@@ -196,6 +220,9 @@ private:
 	crl::time _lastUpdateTime = 0;
 	bool _handlingChannelDifference = false;
 
+	std::unique_ptr<PendingDifference> _pendingDifference;
+	rpl::variable<DifferenceProgress> _differenceProgress;
+
 	base::flat_map<int, ActiveChatTracker> _activeChats;
 	base::flat_map<
 		not_null<PeerData*>,
@@ -104,7 +104,7 @@ void ViewsManager::viewsIncrement() {
 			done(ids, result, requestId);
 		}).fail([=](const MTP::Error &error, mtpRequestId requestId) {
 			fail(error, requestId);
-		}).afterDelay(5).send();
+		}).afterDelay(5).priority(MTP::RequestPriority::Prefetch).send();
 
 		_incrementRequests.emplace(i->first, requestId);
 		i = _toIncrement.erase(i);
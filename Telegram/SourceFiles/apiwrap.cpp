@@ -45,6 +45,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_saved_sublist.h"
 #include "data/data_search_controller.h"
 #include "data/data_session.h"
+#include "data/data_shared_media_cache.h"
 #include "data/data_channel.h"
 #include "data/data_chat.h"
 #include "data/data_user.h"
@@ -1167,7 +1168,9 @@ void ApiWrap::requestFullPeer(not_null<PeerData*> peer) {
 					_session->data().processChats(data.vchats());
 				});
 				gotUserFull(user, result);
-			}).fail(failHandler).send();
+			}).fail(failHandler).priority(
+				MTP::RequestPriority::Prefetch
+			).send();
 		} else if (const auto chat = peer->asChat()) {
 			return request(MTPmessages_GetFullChat(
 				chat->inputChat
@@ -1472,7 +1475,9 @@ void ApiWrap::requestStickerSets() {
 			gotStickerSet(setId, result);
 		}).fail([=, setId = id] {
 			_stickerSetRequests.remove(setId);
-		}).afterDelay(kSmallDelayMs).send();
+		}).afterDelay(kSmallDelayMs).priority(
+			MTP::RequestPriority::Prefetch
+		).send();
 	}
 }
 
@@ -3185,6 +3190,41 @@ void ApiWrap::requestSharedMedia(
 		messageId,
 		slice,
 	};
+	using Data::SharedMediaCache;
+	if (_sharedMediaRequests.contains(key)) {
+		return;
+	} else if (SharedMediaCache::IsNewestPage(topicRootId, messageId)) {
+		_sharedMediaRequests.emplace(key);
+		auto &cache = _session->data().sharedMediaCache();
+		cache.apply(peer, type, crl::guard(_session, [=](bool fresh) {
+			_sharedMediaRequests.remove(key);
+			if (!fresh) {
+				sendSharedMediaRequest(
+					peer,
+					topicRootId,
+					type,
+					messageId,
+					slice);
+			}
+		}));
+		return;
+	}
+	sendSharedMediaRequest(peer, topicRootId, type, messageId, slice);
+}
+
+void ApiWrap::sendSharedMediaRequest(
+		not_null<PeerData*> peer,
+		MsgId topicRootId,
+		SharedMediaType type,
+		MsgId messageId,
+		SliceType slice) {
+	const auto key = SharedMediaRequest{
+		peer,
+		topicRootId,
+		type,
+		messageId,
+		slice,
+	};
 	if (_sharedMediaRequests.contains(key)) {
 		return;
 	}
@@ -3200,6 +3240,9 @@ void ApiWrap::requestSharedMedia(
 		return;
 	}
 
+	const auto newestPage = Data::SharedMediaCache::IsNewestPage(
+		topicRootId,
+		messageId);
 	const auto history = _session->data().history(peer);
 	auto &histories = history->owner().histories();
 	const auto requestType = Data::Histories::RequestType::History;
@@ -3214,6 +3257,11 @@ void ApiWrap::requestSharedMedia(
 				messageId,
 				slice,
 				result);
+			if (newestPage) {
+				auto &cache = _session->data().sharedMediaCache();
+				cache.replaceProvisional(peer, type, result, parsed);
+				cache.remember(peer, type, result, parsed);
+			}
 			sharedMediaDone(peer, topicRootId, type, std::move(parsed));
 			finish();
 		}).fail([=] {
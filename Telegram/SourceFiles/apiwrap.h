@@ -501,6 +501,12 @@ private:
 		const QDate &date,
 		Callback &&callback);
 
+	void sendSharedMediaRequest(
+		not_null<PeerData*> peer,
+		MsgId topicRootId,
+		SharedMediaType type,
+		MsgId messageId,
+		SliceType slice);
 	void sharedMediaDone(
 		not_null<PeerData*> peer,
 		MsgId topicRootId,
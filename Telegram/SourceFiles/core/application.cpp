@@ -61,6 +61,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/file_utilities.h"
 #include "core/click_handler_types.h" // ClickHandlerContext.
 #include "core/crash_reports.h"
+#include "core/tracing.h"
 #include "main/main_account.h"
 #include "main/main_domain.h"
 #include "main/main_session.h"
@@ -74,6 +75,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "media/player/media_player_instance.h"
 #include "media/player/media_player_float.h"
 #include "media/clip/media_clip_reader.h" // For Media::Clip::Finish().
+#include "media/media_animation_budget.h"
 #include "media/system_media_controls_manager.h"
 #include "window/notifications_manager.h"
 #include "window/themes/window_theme.h"
@@ -173,6 +175,7 @@ Application::Application()
 , _mediaDevices(std::make_unique<Webrtc::Environment>())
 , _databases(std::make_unique<Storage::Databases>())
 , _animationsManager(std::make_unique<Ui::Animations::Manager>())
+, _animationBudget(std::make_unique<Media::AnimationBudget>())
 , _clearEmojiImageLoaderTimer([=] { clearEmojiSourceImages(); })
 , _audio(std::make_unique<Media::Audio::Instance>())
 , _fallbackProductionConfig(
@@ -274,6 +277,8 @@ Application::~Application() {
 }
 
 void Application::run() {
+	const auto span = Tracing::Span("Core::Application::run");
+
 	// Depends on OpenSSL on macOS, so on ThirdParty::start().
 	// Depends on notifications settings.
 	_notifications = std::make_unique<Window::Notifications::System>();
@@ -324,6 +329,7 @@ void Application::run() {
 		settings().ignoreBatterySavingValue()
 	) | rpl::start_with_next([=](bool saving, bool ignore) {
 		PowerSaving::SetForceAll(saving && !ignore);
+		_animationBudget->setReduced(saving && !ignore);
 	}, _lifetime);
 
 	style::ShortAnimationPlaying(
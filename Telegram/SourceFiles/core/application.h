@@ -80,6 +80,7 @@ class FloatController;
 class FloatDelegate;
 } // namespace Player
 class SystemMediaControlsManager;
+class AnimationBudget;
 } // namespace Media
 
 namespace Lang {
@@ -268,6 +269,9 @@ public:
 	-> const crl::object_on_queue<Stickers::EmojiImageLoader> & {
 		return _emojiImageLoader;
 	}
+	[[nodiscard]] Media::AnimationBudget &animationBudget() {
+		return *_animationBudget;
+	}
 
 	// Internal links.
 	void checkStartUrl();
@@ -408,6 +412,7 @@ private:
 
 	const std::unique_ptr<Storage::Databases> _databases;
 	const std::unique_ptr<Ui::Animations::Manager> _animationsManager;
+	const std::unique_ptr<Media::AnimationBudget> _animationBudget;
 	crl::object_on_queue<Stickers::EmojiImageLoader> _emojiImageLoader;
 	base::Timer _clearEmojiImageLoaderTimer;
 	const std::unique_ptr<Media::Audio::Instance> _audio;
@@ -225,7 +225,8 @@ QByteArray Settings::serialize() const {
 		+ Serialize::stringSize(noWarningExtensions)
 		+ Serialize::stringSize(_customFontFamily)
 		+ sizeof(qint32) * 3
-		+ Serialize::bytearraySize(_tonsiteStorageToken);
+		+ Serialize::bytearraySize(_tonsiteStorageToken)
+		+ sizeof(qint32) * 2;
 
 	auto result = QByteArray();
 	result.reserve(size);
@@ -379,7 +380,9 @@ QByteArray Settings::serialize() const {
 				1000000))
 			<< qint32(_systemUnlockEnabled ? 1 : 0)
 			<< qint32(!_weatherInCelsius ? 0 : *_weatherInCelsius ? 1 : 2)
-			<< _tonsiteStorageToken;
+			<< _tonsiteStorageToken
+			<< qint32(_localMessagesCache.current() ? 1 : 0)
+			<< qint32(_chatsMemoryBudget);
 	}
 
 	Ensures(result.size() == size);
@@ -504,6 +507,8 @@ void Settings::addFromSerialized(const QByteArray &serialized) {
 	qint32 systemUnlockEnabled = _systemUnlockEnabled ? 1 : 0;
 	qint32 weatherInCelsius = !_weatherInCelsius ? 0 : *_weatherInCelsius ? 1 : 2;
 	QByteArray tonsiteStorageToken = _tonsiteStorageToken;
+	qint32 localMessagesCache = _localMessagesCache.current() ? 1 : 0;
+	qint32 chatsMemoryBudget = _chatsMemoryBudget;
 
 	stream >> themesAccentColors;
 	if (!stream.atEnd()) {
@@ -810,6 +815,12 @@ void Settings::addFromSerialized(const QByteArray &serialized) {
 	if (!stream.atEnd()) {
 		stream >> tonsiteStorageToken;
 	}
+	if (!stream.atEnd()) {
+		stream >> localMessagesCache;
+	}
+	if (!stream.atEnd()) {
+		stream >> chatsMemoryBudget;
+	}
 	if (stream.status() != QDataStream::Ok) {
 		LOG(("App Error: "
 			"Bad data for Core::Settings::constructFromSerialized()"));
@@ -1023,6 +1034,8 @@ void Settings::addFromSerialized(const QByteArray &serialized) {
 		? std::optional<bool>()
 		: (weatherInCelsius == 1);
 	_tonsiteStorageToken = tonsiteStorageToken;
+	_localMessagesCache = (localMessagesCache == 1);
+	_chatsMemoryBudget = std::max(chatsMemoryBudget, 0);
 }
 
 QString Settings::getSoundPath(const QString &key) const {
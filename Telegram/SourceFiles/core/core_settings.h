@@ -897,6 +897,24 @@ public:
 		_systemUnlockEnabled = enabled;
 	}
 
+	[[nodiscard]] bool localMessagesCache() const {
+		return _localMessagesCache.current();
+	}
+	[[nodiscard]] rpl::producer<bool> localMessagesCacheChanges() const {
+		return _localMessagesCache.changes();
+	}
+	void setLocalMessagesCache(bool enabled) {
+		_localMessagesCache = enabled;
+	}
+
+	// Megabytes for loaded chats of each account, zero for no limit.
+	[[nodiscard]] int chatsMemoryBudget() const {
+		return _chatsMemoryBudget;
+	}
+	void setChatsMemoryBudget(int megabytes) {
+		_chatsMemoryBudget = megabytes;
+	}
+
 	[[nodiscard]] std::optional<bool> weatherInCelsius() const {
 		return _weatherInCelsius;
 	}
@@ -1044,6 +1062,8 @@ private:
 	bool _systemUnlockEnabled = false;
 	std::optional<bool> _weatherInCelsius;
 	QByteArray _tonsiteStorageToken;
+	rpl::variable<bool> _localMessagesCache = false;
+	int _chatsMemoryBudget = 0;
 
 	bool _tabbedReplacedWithInfo = false; // per-window
 	rpl::event_stream<bool> _tabbedReplacedWithInfoValue; // per-window
@@ -0,0 +1,137 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/tracing.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+
+#include <chrono>
+#include <mutex>
+
+namespace Tracing {
+namespace details {
+
+std::atomic<bool> Enabled = false;
+
+} // namespace details
+namespace {
+
+constexpr auto kMaxEvents = (1 << 18);
+
+struct Event {
+	const char *name = nullptr;
+	int64 start = 0;
+	int64 duration = -1; // Instant event.
+	int64 id = -1;
+	int thread = 0;
+};
+
+std::mutex Mutex;
+std::vector<Event> Events;
+std::atomic<int> ThreadCounter = 0;
+
+[[nodiscard]] int CurrentThread() {
+	thread_local const auto result = ++ThreadCounter;
+	return result;
+}
+
+void Push(Event &&event) {
+	event.thread = CurrentThread();
+
+	const auto lock = std::lock_guard(Mutex);
+	if (int(Events.size()) < kMaxEvents) {
+		Events.push_back(std::move(event));
+	}
+}
+
+[[nodiscard]] QByteArray Serialize(const std::vector<Event> &events) {
+	auto result = QByteArray();
+	result.reserve(128 * (int(events.size()) + 1));
+	result.append(R"({"traceEvents":[)");
+
+	// Start() is called from the main thread, so it always has id 1.
+	result.append(R"({"name":"thread_name","ph":"M","pid":1,"tid":1,)");
+	result.append(R"("args":{"name":"main"}})");
+	for (const auto &event : events) {
+		result.append(R"(,{"name":")").append(event.name);
+		result.append(R"(","cat":"startup","ph":")");
+		result.append((event.duration >= 0) ? "X" : "i");
+		result.append(R"(","ts":)").append(QByteArray::number(event.start));
+		if (event.duration >= 0) {
+			result.append(R"(,"dur":)").append(
+				QByteArray::number(event.duration));
+		} else {
+			result.append(R"(,"s":"t")");
+		}
+		result.append(R"(,"pid":1,"tid":)").append(
+			QByteArray::number(event.thread));
+		if (event.id >= 0) {
+			result.append(R"(,"args":{"id":)").append(
+				QByteArray::number(event.id)).append('}');
+		}
+		result.append('}');
+	}
+	result.append(R"(],"displayTimeUnit":"ms"})");
+	return result;
+}
+
+} // namespace
+
+namespace details {
+
+int64 Now() {
+	using namespace std::chrono;
+	return duration_cast<microseconds>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+void Record(const char *name, int64 start, int64 duration, int64 id) {
+	Push({ .name = name, .start = start, .duration = duration, .id = id });
+}
+
+} // namespace details
+
+void Start() {
+	CurrentThread();
+	{
+		const auto lock = std::lock_guard(Mutex);
+		Events.reserve(1024);
+	}
+	details::Enabled = true;
+}
+
+void Finish(const QString &path) {
+	if (!Enabled()) {
+		return;
+	}
+	details::Enabled = false;
+
+	auto events = std::vector<Event>();
+	{
+		const auto lock = std::lock_guard(Mutex);
+		events = base::take(Events);
+	}
+	QDir().mkpath(QFileInfo(path).absolutePath());
+	auto f = QFile(path);
+	if (!f.open(QIODevice::WriteOnly)) {
+		LOG(("Tracing Error: could not open '%1' for writing.").arg(path));
+		return;
+	}
+	f.write(Serialize(events));
+	LOG(("Tracing Info: %1 events written to '%2'."
+		).arg(events.size()
+		).arg(path));
+}
+
+void Instant(const char *name, int64 id) {
+	if (Enabled()) {
+		Push({ .name = name, .start = details::Now(), .id = id });
+	}
+}
+
+} // namespace Tracing
@@ -0,0 +1,59 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <atomic>
+
+// Startup phase tracing, enabled by the -trace command line argument.
+// Collected events are written in the Chrome Trace Event format,
+// so they can be opened in chrome://tracing or ui.perfetto.dev.
+namespace Tracing {
+namespace details {
+
+extern std::atomic<bool> Enabled;
+
+[[nodiscard]] int64 Now();
+void Record(const char *name, int64 start, int64 duration, int64 id);
+
+} // namespace details
+
+[[nodiscard]] inline bool Enabled() {
+	return details::Enabled.load(std::memory_order_relaxed);
+}
+
+void Start();
+void Finish(const QString &path);
+
+// The name must be a string literal, it is stored without copying.
+// The id is written to the event arguments if it is not negative,
+// for example to tell apart the phases of different accounts.
+void Instant(const char *name, int64 id = -1);
+
+class Span final {
+public:
+	explicit Span(const char *name, int64 id = -1)
+	: _name(name)
+	, _id(id)
+	, _start(Enabled() ? details::Now() : -1) {
+	}
+	Span(const Span &other) = delete;
+	Span &operator=(const Span &other) = delete;
+	~Span() {
+		if (_start >= 0) {
+			details::Record(_name, _start, details::Now() - _start, _id);
+		}
+	}
+
+private:
+	const char *_name = nullptr;
+	int64 _id = -1;
+	int64 _start = -1;
+
+};
+
+} // namespace Tracing
@@ -0,0 +1,195 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/components/memory_manager.h"
+
+#include "core/application.h"
+#include "core/core_settings.h"
+#include "data/data_session.h"
+#include "dialogs/dialogs_key.h"
+#include "history/view/media/history_view_media.h"
+#include "history/view/history_view_element.h"
+#include "history/history.h"
+#include "main/main_session.h"
+#include "window/window_session_controller.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kCheckTimeout = 30 * crl::time(1000);
+constexpr auto kMinIdleTime = 5 * 60 * crl::time(1000);
+
+// Rough cost of a view with its text layout, without images.
+constexpr auto kElementSize = int64(2048);
+
+// Rough cost of the animated custom emoji frames held by a view.
+constexpr auto kCustomEmojiSize = int64(64 * 1024);
+
+} // namespace
+
+MemoryManager::MemoryManager(not_null<Main::Session*> session)
+: _session(session)
+, _timer([=] { check(); }) {
+	_session->data().historyUnloaded(
+	) | rpl::start_with_next([=](not_null<const History*> history) {
+		_touched.remove(const_cast<History*>(history.get()));
+	}, _lifetime);
+
+	_session->data().heavyViewPartAdded(
+	) | rpl::start_with_next([=](not_null<HistoryView::Element*> view) {
+		heavyPartAdded(view);
+	}, _lifetime);
+
+	_session->data().heavyViewPartRemoved(
+	) | rpl::start_with_next([=](not_null<HistoryView::Element*> view) {
+		heavyPartRemoved(view);
+	}, _lifetime);
+
+	_timer.callEach(kCheckTimeout);
+}
+
+MemoryManager::~MemoryManager() = default;
+
+void MemoryManager::touch(not_null<History*> history) {
+	_touched[history] = crl::now();
+}
+
+auto MemoryManager::usage() const -> Usage {
+	auto result = Usage();
+	for (const auto &[history, touched] : _touched) {
+		result.bytes += footprint(history);
+		++result.histories;
+	}
+	return result;
+}
+
+void MemoryManager::check() {
+	const auto now = crl::now();
+	touchShown(now);
+
+	const auto budget = Core::App().settings().chatsMemoryBudget();
+	if (!budget || _touched.empty()) {
+		return;
+	}
+	auto total = int64();
+	auto candidates = std::vector<std::pair<crl::time, History*>>();
+	candidates.reserve(_touched.size());
+	for (const auto &[history, touched] : _touched) {
+		total += footprint(history);
+		if (touched + kMinIdleTime <= now) {
+			candidates.emplace_back(touched, history.get());
+		}
+	}
+	const auto limit = int64(budget) * 1024 * 1024;
+	if (total <= limit) {
+		return;
+	}
+	ranges::sort(candidates);
+
+	// Decoded media is cheap to restore, drop it before any chat views.
+	auto freed = int64();
+	for (const auto &[touched, history] : candidates) {
+		if (total <= limit) {
+			break;
+		}
+		const auto bytes = unloadHeavyParts(history);
+		total -= bytes;
+		freed += bytes;
+	}
+	auto unloaded = 0;
+	for (const auto &[touched, history] : candidates) {
+		if (total <= limit) {
+			break;
+		}
+		total -= footprint(history);
+		history->clear(History::ClearType::Unload);
+		_touched.remove(history);
+		++unloaded;
+	}
+	DEBUG_LOG(("Memory Info: freed %1 KB of media, unloaded %2 chats, "
+		"left about %3 KB."
+		).arg(freed / 1024
+		).arg(unloaded
+		).arg(total / 1024));
+}
+
+void MemoryManager::touchShown(crl::time now) {
+	for (const auto &window : _session->windows()) {
+		if (const auto history = window->activeChatCurrent().history()) {
+			_touched[history] = now;
+			if (const auto migrated = history->migrateFrom()) {
+				_touched[migrated] = now;
+			}
+		}
+	}
+}
+
+void MemoryManager::heavyPartAdded(not_null<HistoryView::Element*> view) {
+	const auto history = view->history();
+	auto bytes = kCustomEmojiSize;
+	if (const auto media = view->media()) {
+		// Decoded images are held for the visible media size.
+		const auto ratio = int64(style::DevicePixelRatio());
+		bytes += int64(media->width())
+			* media->height()
+			* ratio
+			* ratio
+			* 4;
+	}
+	_heavy.emplace(view, HeavyPart{ history, bytes });
+	_heavyBytes[history] += bytes;
+
+	// Heavy parts are registered while painting, so the chat is shown.
+	touch(history);
+}
+
+void MemoryManager::heavyPartRemoved(not_null<HistoryView::Element*> view) {
+	// The view may be in its destructor already, don't touch it here.
+	const auto i = _heavy.find(view);
+	if (i == end(_heavy)) {
+		return;
+	}
+	const auto part = i->second;
+	_heavy.erase(i);
+	const auto j = _heavyBytes.find(part.history);
+	if (j != end(_heavyBytes)) {
+		j->second -= part.bytes;
+		if (j->second <= 0) {
+			_heavyBytes.erase(j);
+		}
+	}
+}
+
+int64 MemoryManager::footprint(not_null<History*> history) const {
+	auto result = int64();
+	for (const auto &block : history->blocks) {
+		result += int64(block->messages.size()) * kElementSize;
+	}
+	const auto i = _heavyBytes.find(history);
+	return result + ((i != end(_heavyBytes)) ? i->second : 0);
+}
+
+int64 MemoryManager::unloadHeavyParts(not_null<History*> history) {
+	const auto i = _heavyBytes.find(history);
+	if (i == end(_heavyBytes)) {
+		return 0;
+	}
+	const auto was = i->second;
+	auto views = std::vector<not_null<HistoryView::Element*>>();
+	for (const auto &[view, part] : _heavy) {
+		if (part.history == history) {
+			views.push_back(view);
+		}
+	}
+	for (const auto view : views) {
+		view->unloadHeavyPart();
+	}
+	const auto j = _heavyBytes.find(history);
+	return was - ((j != end(_heavyBytes)) ? j->second : 0);
+}
+
+} // namespace Data
@@ -0,0 +1,66 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/timer.h"
+
+class History;
+
+namespace HistoryView {
+class Element;
+} // namespace HistoryView
+
+namespace Main {
+class Session;
+} // namespace Main
+
+namespace Data {
+
+// Keeps the views of loaded chats within the budget from Core::Settings.
+// When over budget the decoded media of chats that were not shown for a
+// while is dropped least recently shown first, then those chats are
+// unloaded in the same order, their messages are requested again when
+// they are opened.
+class MemoryManager final {
+public:
+	explicit MemoryManager(not_null<Main::Session*> session);
+	~MemoryManager();
+
+	struct Usage {
+		int64 bytes = 0;
+		int histories = 0;
+	};
+
+	void touch(not_null<History*> history);
+	[[nodiscard]] Usage usage() const;
+
+private:
+	struct HeavyPart {
+		not_null<History*> history;
+		int64 bytes = 0;
+	};
+
+	void check();
+	void touchShown(crl::time now);
+	void heavyPartAdded(not_null<HistoryView::Element*> view);
+	void heavyPartRemoved(not_null<HistoryView::Element*> view);
+	[[nodiscard]] int64 footprint(not_null<History*> history) const;
+	[[nodiscard]] int64 unloadHeavyParts(not_null<History*> history);
+
+	const not_null<Main::Session*> _session;
+
+	base::flat_map<not_null<History*>, crl::time> _touched;
+	base::flat_map<not_null<HistoryView::Element*>, HeavyPart> _heavy;
+	base::flat_map<not_null<History*>, int64> _heavyBytes;
+	base::Timer _timer;
+
+	rpl::lifetime _lifetime;
+
+};
+
+} // namespace Data
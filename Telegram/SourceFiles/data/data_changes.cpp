@@ -50,6 +50,25 @@ rpl::producer<UpdateType> Changes::Manager<DataType, UpdateType>::updates(
 	});
 }
 
+template <typename DataType, typename UpdateType>
+auto Changes::Manager<DataType, UpdateType>::batches(Flags flags) const
+-> rpl::producer<std::vector<UpdateType>> {
+	return _batches.events(
+	) | rpl::map([=] {
+		Expects(_batch != nullptr);
+
+		auto result = std::vector<UpdateType>();
+		for (const auto &[data, updateFlags] : *_batch) {
+			if (updateFlags & flags) {
+				result.push_back({ data, updateFlags });
+			}
+		}
+		return result;
+	}) | rpl::filter([](const std::vector<UpdateType> &list) {
+		return !list.empty();
+	});
+}
+
 template <typename DataType, typename UpdateType>
 rpl::producer<UpdateType> Changes::Manager<DataType, UpdateType>::updates(
 		not_null<DataType*> data,
@@ -83,9 +102,15 @@ void Changes::Manager<DataType, UpdateType>::drop(not_null<DataType*> data) {
 
 template <typename DataType, typename UpdateType>
 void Changes::Manager<DataType, UpdateType>::sendNotifications() {
-	for (const auto &[data, flags] : base::take(_updates)) {
+	const auto updates = base::take(_updates);
+	for (const auto &[data, flags] : updates) {
 		_stream.fire({ data, flags });
 	}
+	if (!updates.empty()) {
+		const auto was = std::exchange(_batch, &updates);
+		_batches.fire({});
+		_batch = was;
+	}
 }
 
 Changes::Changes(not_null<Main::Session*> session) : _session(session) {
@@ -122,6 +147,11 @@ rpl::producer<PeerUpdate> Changes::peerUpdates(
 	return _peerChanges.updates(flags);
 }
 
+auto Changes::peerUpdatesBatched(PeerUpdate::Flags flags) const
+-> rpl::producer<std::vector<PeerUpdate>> {
+	return _peerChanges.batches(flags);
+}
+
 rpl::producer<PeerUpdate> Changes::peerUpdates(
 		not_null<PeerData*> peer,
 		PeerUpdate::Flags flags) const {
@@ -251,6 +281,11 @@ rpl::producer<EntryUpdate> Changes::entryUpdates(
 	return _entryChanges.updates(flags);
 }
 
+auto Changes::entryUpdatesBatched(EntryUpdate::Flags flags) const
+-> rpl::producer<std::vector<EntryUpdate>> {
+	return _entryChanges.batches(flags);
+}
+
 rpl::producer<EntryUpdate> Changes::entryUpdates(
 		not_null<Dialogs::Entry*> entry,
 		EntryUpdate::Flags flags) const {
@@ -260,6 +260,8 @@ public:
 	void peerUpdated(not_null<PeerData*> peer, PeerUpdate::Flags flags);
 	[[nodiscard]] rpl::producer<PeerUpdate> peerUpdates(
 		PeerUpdate::Flags flags) const;
+	[[nodiscard]] auto peerUpdatesBatched(PeerUpdate::Flags flags) const
+		-> rpl::producer<std::vector<PeerUpdate>>;
 	[[nodiscard]] rpl::producer<PeerUpdate> peerUpdates(
 		not_null<PeerData*> peer,
 		PeerUpdate::Flags flags) const;
@@ -317,6 +319,8 @@ public:
 		EntryUpdate::Flags flags);
 	[[nodiscard]] rpl::producer<EntryUpdate> entryUpdates(
 		EntryUpdate::Flags flags) const;
+	[[nodiscard]] auto entryUpdatesBatched(EntryUpdate::Flags flags) const
+		-> rpl::producer<std::vector<EntryUpdate>>;
 	[[nodiscard]] rpl::producer<EntryUpdate> entryUpdates(
 		not_null<Dialogs::Entry*> entry,
 		EntryUpdate::Flags flags) const;
@@ -355,6 +359,8 @@ private:
 			Flags flags,
 			bool dropScheduled = false);
 		[[nodiscard]] rpl::producer<UpdateType> updates(Flags flags) const;
+		[[nodiscard]] rpl::producer<std::vector<UpdateType>> batches(
+			Flags flags) const;
 		[[nodiscard]] rpl::producer<UpdateType> updates(
 			not_null<DataType*> data,
 			Flags flags) const;
@@ -375,10 +381,16 @@ private:
 			not_null<DataType*> data,
 			Flags flags);
 
+		using Updates = base::flat_map<not_null<DataType*>, Flags>;
+
 		std::array<rpl::event_stream<UpdateType>, kCount> _realtimeStreams;
-		base::flat_map<not_null<DataType*>, Flags> _updates;
+		Updates _updates;
 		rpl::event_stream<UpdateType> _stream;
 
+		// Everything sent in one notifications pass, while it is sent.
+		const Updates *_batch = nullptr;
+		rpl::event_stream<> _batches;
+
 	};
 
 	void scheduleNotifications();
@@ -281,9 +281,9 @@ const base::flat_set<not_null<History*>> &ChatFilter::never() const {
 	return _never;
 }
 
-bool ChatFilter::contains(not_null<History*> history) const {
-	const auto flag = [&] {
-		const auto peer = history->peer;
+ChatFilter::Flags ChatFilter::RulesFor(not_null<History*> history) {
+	const auto peer = history->peer;
+	auto result = Flags([&] {
 		if (const auto user = peer->asUser()) {
 			return user->isBot()
 				? Flag::Bots
@@ -299,28 +299,43 @@ bool ChatFilter::contains(not_null<History*> history) const {
 				return Flag::Groups;
 			}
 		} else {
-			Unexpected("Peer type in ChatFilter::contains.");
+			Unexpected("Peer type in ChatFilter::RulesFor.");
 		}
-	}();
+	}());
+	const auto notArchived = history->folderKnown() && !history->folder();
+	const auto state = history->chatListBadgesState();
+	if (!history->muted() || (state.mention && notArchived)) {
+		result |= Flag::NoMuted;
+	}
+	if (state.unread
+		|| state.mention
+		|| history->fakeUnreadWhileOpened()) {
+		result |= Flag::NoRead;
+	}
+	if (notArchived) {
+		result |= Flag::NoArchived;
+	}
+	return result;
+}
+
+bool ChatFilter::contains(not_null<History*> history) const {
+	return contains(history, RulesFor(history));
+}
+
+bool ChatFilter::contains(
+		not_null<History*> history,
+		Flags rules) const {
+	const auto types = Flag::Contacts
+		| Flag::NonContacts
+		| Flag::Groups
+		| Flag::Channels
+		| Flag::Bots;
+	const auto conditions = _flags
+		& (Flag::NoMuted | Flag::NoRead | Flag::NoArchived);
 	if (_never.contains(history)) {
 		return false;
 	}
-	const auto state = (_flags & (Flag::NoMuted | Flag::NoRead))
-		? history->chatListBadgesState()
-		: Dialogs::BadgesState();
-	return false
-		|| ((_flags & flag)
-			&& (!(_flags & Flag::NoMuted)
-				|| !history->muted()
-				|| (state.mention
-					&& history->folderKnown()
-					&& !history->folder()))
-			&& (!(_flags & Flag::NoRead)
-				|| state.unread
-				|| state.mention
-				|| history->fakeUnreadWhileOpened())
-			&& (!(_flags & Flag::NoArchived)
-				|| (history->folderKnown() && !history->folder())))
+	return ((_flags & rules & types) && ((conditions & rules) == conditions))
 		|| _always.contains(history);
 }
 
@@ -352,6 +367,7 @@ not_null<Dialogs::MainList*> ChatFilters::chatsList(FilterId filterId) {
 void ChatFilters::clear() {
 	_chatsLists.clear();
 	_list.clear();
+	_historyRules.clear();
 }
 
 void ChatFilters::setPreloaded(const QVector<MTPDialogFilter> &result) {
@@ -615,6 +631,7 @@ void ChatFilters::applyRemove(int position) {
 	const auto i = begin(_list) + position;
 	applyChange(*i, ChatFilter(i->id(), {}, {}, {}, {}, {}, {}, {}));
 	_list.erase(i);
+	_historyRules.clear();
 }
 
 bool ChatFilters::applyChange(ChatFilter &filter, ChatFilter &&updated) {
@@ -641,8 +658,9 @@ bool ChatFilters::applyChange(ChatFilter &filter, ChatFilter &&updated) {
 	if (rulesChanged) {
 		const auto filterList = _owner->chatsFilters().chatsList(id);
 		const auto feedHistory = [&](not_null<History*> history) {
-			const auto now = updated.contains(history);
-			const auto was = filter.contains(history);
+			const auto rules = ChatFilter::RulesFor(history);
+			const auto now = updated.contains(history, rules);
+			const auto was = filter.contains(history, rules);
 			if (now != was) {
 				if (now) {
 					history->addToChatList(id, filterList);
@@ -880,6 +898,21 @@ void ChatFilters::refreshHistory(not_null<History*> history) {
 	}
 }
 
+bool ChatFilters::rememberRules(
+		not_null<History*> history,
+		ChatFilter::Flags rules) {
+	auto &remembered = _historyRules[history];
+	if (remembered == rules) {
+		return false;
+	}
+	remembered = rules;
+	return true;
+}
+
+void ChatFilters::forgetRules(not_null<const History*> history) {
+	_historyRules.remove(const_cast<History*>(history.get()));
+}
+
 void ChatFilters::requestSuggested() {
 	if (_suggestedRequestId) {
 		return;
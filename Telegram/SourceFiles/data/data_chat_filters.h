@@ -80,7 +80,14 @@ public:
 	[[nodiscard]] const std::vector<not_null<History*>> &pinned() const;
 	[[nodiscard]] const base::flat_set<not_null<History*>> &never() const;
 
+	// The peer type flag of the history together with those of NoMuted,
+	// NoRead and NoArchived rules that the history passes.
+	[[nodiscard]] static Flags RulesFor(not_null<History*> history);
+
 	[[nodiscard]] bool contains(not_null<History*> history) const;
+	[[nodiscard]] bool contains(
+		not_null<History*> history,
+		Flags rules) const;
 
 private:
 	FilterId _id = 0;
@@ -149,6 +156,11 @@ public:
 
 	void refreshHistory(not_null<History*> history);
 
+	// Returns false if the history rules didn't change since last time,
+	// so the filters membership of the history stays the same.
+	bool rememberRules(not_null<History*> history, ChatFilter::Flags rules);
+	void forgetRules(not_null<const History*> history);
+
 	[[nodiscard]] not_null<Dialogs::MainList*> chatsList(FilterId filterId);
 	void clear();
 
@@ -207,6 +219,7 @@ private:
 
 	std::vector<ChatFilter> _list;
 	base::flat_map<FilterId, std::unique_ptr<Dialogs::MainList>> _chatsLists;
+	base::flat_map<not_null<History*>, ChatFilter::Flags> _historyRules;
 	rpl::event_stream<> _listChanged;
 	rpl::event_stream<FilterId> _isChatlistChanged;
 	mtpRequestId _loadRequestId = 0;
@@ -509,7 +509,7 @@ void Histories::requestFakeChatListMessage(
 				MTP_vector<MTPChat>(0),
 				MTP_vector<MTPUser>(0)));
 			finish();
-		}).send();
+		}).priority(MTP::RequestPriority::Prefetch).send();
 	});
 }
 
@@ -550,7 +550,7 @@ void Histories::requestGroupAround(not_null<HistoryItem*> item) {
 		}).fail([=] {
 			_chatListGroupRequests.remove(key);
 			finish();
-		}).send();
+		}).priority(MTP::RequestPriority::Prefetch).send();
 	});
 	_chatListGroupRequests.emplace(
 		key,
@@ -640,7 +640,9 @@ void Histories::sendReadRequest(not_null<History*> history, State &state) {
 			return session().api().request(MTPchannels_ReadHistory(
 				channel->inputChannel,
 				MTP_int(tillId)
-			)).done(finished).fail(finished).send();
+			)).done(finished).fail(finished).priority(
+				MTP::RequestPriority::Prefetch
+			).send();
 		} else {
 			return session().api().request(MTPmessages_ReadHistory(
 				history->peer->input,
@@ -650,7 +652,7 @@ void Histories::sendReadRequest(not_null<History*> history, State &state) {
 				finished();
 			}).fail([=] {
 				finished();
-			}).send();
+			}).priority(MTP::RequestPriority::Prefetch).send();
 		}
 	});
 }
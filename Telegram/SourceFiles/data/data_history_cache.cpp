@@ -0,0 +1,422 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_history_cache.h"
+
+#include "core/application.h"
+#include "core/core_settings.h"
+#include "data/data_peer.h"
+#include "data/data_session.h"
+#include "history/history.h"
+#include "main/main_session.h"
+#include "storage/cache/storage_cache_database.h"
+#include "storage/serialize_common.h"
+#include "storage/serialize_peer.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kSliceLimit = 50;
+constexpr auto kWriteDelay = 3 * crl::time(1000);
+constexpr auto kMaxMessageSize = 64 * 1024;
+
+} // namespace
+
+QByteArray SerializeMessage(const MTPMessage &message) {
+	auto buffer = mtpBuffer();
+	message.write(buffer);
+	const auto size = int(buffer.size() * sizeof(mtpPrime));
+	if (size > kMaxMessageSize) {
+		return QByteArray();
+	}
+	return QByteArray(
+		reinterpret_cast<const char*>(buffer.constData()),
+		size);
+}
+
+std::optional<MTPMessage> DeserializeMessage(const QByteArray &bytes) {
+	auto from = reinterpret_cast<const mtpPrime*>(bytes.constData());
+	const auto till = from + (bytes.size() / sizeof(mtpPrime));
+	auto result = MTPMessage();
+	if (!result.read(from, till)) {
+		return std::nullopt;
+	}
+	return result;
+}
+
+void CollectMessagePeers(
+		const MTPMessage &message,
+		std::vector<PeerId> &peers) {
+	const auto add = [&](const MTPPeer &peer) {
+		const auto id = peerFromMTP(peer);
+		if (id && !ranges::contains(peers, id)) {
+			peers.push_back(id);
+		}
+	};
+	message.match([](const MTPDmessageEmpty &) {
+	}, [&](const MTPDmessage &data) {
+		if (const auto from = data.vfrom_id()) {
+			add(*from);
+		}
+		if (const auto forwarded = data.vfwd_from()) {
+			if (const auto from = forwarded->data().vfrom_id()) {
+				add(*from);
+			}
+		}
+	}, [&](const MTPDmessageService &data) {
+		if (const auto from = data.vfrom_id()) {
+			add(*from);
+		}
+	});
+}
+
+uint8 MessagesCacheTag(PeerId peerId) {
+	return peerIsChannel(peerId)
+		? kMessagesCacheTag
+		: kNonChannelMessagesCacheTag;
+}
+
+HistoryCache::HistoryCache(not_null<Session*> owner)
+: _owner(owner)
+, _writeTimer([=] { writePending(); }) {
+	Core::App().settings().localMessagesCacheChanges(
+	) | rpl::filter(
+		!rpl::mappers::_1
+	) | rpl::start_with_next([=] {
+		clear();
+	}, _lifetime);
+}
+
+HistoryCache::~HistoryCache() = default;
+
+bool HistoryCache::Enabled() {
+	return Core::App().settings().localMessagesCache();
+}
+
+void HistoryCache::rememberSlice(
+		not_null<History*> history,
+		const QVector<MTPMessage> &messages) {
+	if (!Enabled()) {
+		return;
+	}
+	auto slice = Slice();
+	slice.messages.reserve(std::min(int(messages.size()), kSliceLimit));
+	for (const auto &message : messages) {
+		if (auto prepared = Prepare(message)) {
+			insert(&slice, std::move(*prepared));
+		}
+	}
+	const auto peerId = history->peer->id;
+	_loading.remove(peerId);
+	_slices[peerId] = std::move(slice);
+	writeDelayed(peerId);
+}
+
+void HistoryCache::rememberNew(PeerId peerId, const MTPMessage &message) {
+	const auto i = _slices.find(peerId);
+	if (i == end(_slices) || !Enabled()) {
+		return;
+	} else if (auto prepared = Prepare(message)) {
+		insert(&i->second, std::move(*prepared));
+		writeDelayed(peerId);
+	}
+}
+
+void HistoryCache::rememberEdited(PeerId peerId, const MTPMessage &message) {
+	const auto i = _slices.find(peerId);
+	if (i == end(_slices) || !Enabled()) {
+		return;
+	}
+	auto &list = i->second.messages;
+	const auto id = IdFromMessage(message);
+	const auto j = ranges::find(list, id, &Message::id);
+	if (j == end(list)) {
+		return;
+	} else if (auto prepared = Prepare(message)) {
+		*j = std::move(*prepared);
+	} else {
+		list.erase(j);
+	}
+	writeDelayed(peerId);
+}
+
+void HistoryCache::forget(PeerId peerId, const QVector<MTPint> &ids) {
+	const auto i = _slices.find(peerId);
+	if (i == end(_slices)) {
+		if (Enabled()) {
+			// We don't know what is stored on disk, drop it altogether.
+			forgetAll(peerId);
+		}
+		return;
+	}
+	auto &list = i->second.messages;
+	const auto removed = ranges::remove_if(list, [&](const Message &m) {
+		return ranges::contains(ids, m.id.bare, &MTPint::v);
+	});
+	if (removed != end(list)) {
+		list.erase(removed, end(list));
+		writeDelayed(peerId);
+	}
+}
+
+void HistoryCache::forget(FullMsgId itemId) {
+	forget(itemId.peer, { MTP_int(itemId.msg.bare) });
+}
+
+void HistoryCache::forgetAll(PeerId peerId) {
+	_slices.remove(peerId);
+	_loading.remove(peerId);
+	_writePending.remove(peerId);
+	_owner->cache().remove(HistorySliceCacheKey(peerId));
+}
+
+void HistoryCache::forgetNonChannel(MsgId msgId) {
+	if (!Enabled()) {
+		return;
+	}
+	for (auto &[peerId, slice] : _slices) {
+		if (peerIsChannel(peerId)) {
+			continue;
+		}
+		auto &list = slice.messages;
+		const auto i = ranges::find(list, msgId, &Message::id);
+		if (i != end(list)) {
+			list.erase(i);
+			writeDelayed(peerId);
+			return;
+		}
+	}
+	if (!_nonChannelStoredUnknown) {
+		return;
+	}
+
+	// We can't tell which of the slices on disk has it, so drop them all
+	// and write back the ones we know, they are up to date.
+	_nonChannelStoredUnknown = false;
+	_owner->cache().clearByTag(kNonChannelMessagesCacheTag);
+	for (const auto &[peerId, slice] : _slices) {
+		if (!peerIsChannel(peerId)) {
+			writeDelayed(peerId);
+		}
+	}
+	for (auto i = begin(_loading); i != end(_loading);) {
+		if (!peerIsChannel(*i)) {
+			i = _loading.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+void HistoryCache::clear() {
+	_slices.clear();
+	_loading.clear();
+	_writePending.clear();
+	_writeTimer.cancel();
+	_owner->cache().clearByTag(kMessagesCacheTag);
+	_owner->cache().clearByTag(kNonChannelMessagesCacheTag);
+}
+
+void HistoryCache::load(
+		not_null<History*> history,
+		Fn<void(QVector<MTPMessage>&&)> done) {
+	const auto peerId = history->peer->id;
+	if (!Enabled()) {
+		done({});
+		return;
+	} else if (const auto i = _slices.find(peerId); i != end(_slices)) {
+		done(Parse(i->second));
+		return;
+	}
+	_loading.emplace(peerId);
+	const auto weak = base::make_weak(&_owner->session());
+	_owner->cache().get(HistorySliceCacheKey(peerId), [=](
+			QByteArray &&value) {
+		crl::on_main(weak, [=, value = std::move(value)] {
+			const auto loading = _loading.remove(peerId);
+			if (const auto i = _slices.find(peerId); i != end(_slices)) {
+				done(Parse(i->second));
+				return;
+			} else if (!loading || value.isEmpty()) {
+				done({});
+				return;
+			}
+			auto slice = deserialize(value);
+			if (!slice) {
+				LOG(("App Error: Bad history slice in local cache."));
+				_owner->cache().remove(HistorySliceCacheKey(peerId));
+				done({});
+				return;
+			}
+			done(Parse(_slices.emplace(
+				peerId,
+				std::move(*slice)).first->second));
+		});
+	});
+}
+
+auto HistoryCache::Prepare(const MTPMessage &message)
+-> std::optional<Message> {
+	if (message.type() == mtpc_messageEmpty) {
+		return std::nullopt;
+	}
+	const auto id = IdFromMessage(message);
+	if (!IsServerMsgId(id)) {
+		return std::nullopt;
+	}
+	auto result = Message{ .id = id, .serialized = SerializeMessage(message) };
+	if (result.serialized.isEmpty()) {
+		return std::nullopt;
+	}
+	CollectMessagePeers(message, result.peers);
+	return result;
+}
+
+QVector<MTPMessage> HistoryCache::Parse(const Slice &slice) {
+	auto result = QVector<MTPMessage>();
+	result.reserve(slice.messages.size());
+
+	// Server slices go from the newest message to the oldest one.
+	for (const auto &message : slice.messages | ranges::views::reverse) {
+		if (auto parsed = DeserializeMessage(message.serialized)) {
+			result.push_back(std::move(*parsed));
+		}
+	}
+	return result;
+}
+
+void HistoryCache::insert(not_null<Slice*> slice, Message &&message) {
+	auto &list = slice->messages;
+	const auto i = ranges::lower_bound(
+		list,
+		message.id,
+		ranges::less(),
+		&Message::id);
+	if (i != end(list) && i->id == message.id) {
+		*i = std::move(message);
+	} else if (i != begin(list) || int(list.size()) < kSliceLimit) {
+		list.insert(i, std::move(message));
+	}
+	if (int(list.size()) > kSliceLimit) {
+		list.erase(begin(list), end(list) - kSliceLimit);
+	}
+}
+
+void HistoryCache::writeDelayed(PeerId peerId) {
+	_writePending.emplace(peerId);
+	if (!_writeTimer.isActive()) {
+		_writeTimer.callOnce(kWriteDelay);
+	}
+}
+
+void HistoryCache::writePending() {
+	for (const auto peerId : base::take(_writePending)) {
+		const auto key = HistorySliceCacheKey(peerId);
+		const auto i = _slices.find(peerId);
+		if (i == end(_slices) || i->second.messages.empty()) {
+			_owner->cache().remove(key);
+		} else {
+			_owner->cache().put(key, Storage::Cache::Database::TaggedValue(
+				serialize(peerId, i->second),
+				MessagesCacheTag(peerId)));
+		}
+	}
+}
+
+QByteArray HistoryCache::serialize(
+		PeerId peerId,
+		const Slice &slice) const {
+	auto peers = std::vector<not_null<PeerData*>>();
+	const auto addPeer = [&](PeerId id) {
+		if (const auto peer = _owner->peerLoaded(id)) {
+			if (!ranges::contains(peers, not_null(peer))) {
+				peers.push_back(peer);
+			}
+		}
+	};
+	addPeer(peerId);
+	auto size = 3 * sizeof(quint32); // AppVersion, peers, messages
+	for (const auto &message : slice.messages) {
+		for (const auto id : message.peers) {
+			addPeer(id);
+		}
+		size += sizeof(qint64)
+			+ Serialize::bytearraySize(message.serialized)
+			+ sizeof(quint32)
+			+ message.peers.size() * sizeof(quint64);
+	}
+	for (const auto &peer : peers) {
+		size += Serialize::peerSize(peer);
+	}
+
+	auto stream = Serialize::ByteArrayWriter(size);
+	stream << quint32(AppVersion) << quint32(peers.size());
+	for (const auto &peer : peers) {
+		Serialize::writePeer(stream, peer);
+	}
+	stream << quint32(slice.messages.size());
+	for (const auto &message : slice.messages) {
+		stream
+			<< qint64(message.id.bare)
+			<< message.serialized
+			<< quint32(message.peers.size());
+		for (const auto id : message.peers) {
+			stream << quint64(SerializePeerId(id));
+		}
+	}
+	return std::move(stream).result();
+}
+
+auto HistoryCache::deserialize(const QByteArray &serialized) const
+-> std::optional<Slice> {
+	auto stream = Serialize::ByteArrayReader(serialized);
+	auto streamAppVersion = quint32();
+	auto peersCount = quint32();
+	stream >> streamAppVersion >> peersCount;
+	if (!stream.ok()) {
+		return std::nullopt;
+	}
+	for (auto i = 0; i != int(peersCount); ++i) {
+		const auto peer = Serialize::readPeer(
+			&_owner->session(),
+			streamAppVersion,
+			stream);
+		if (!stream.ok() || !peer) {
+			return std::nullopt;
+		}
+	}
+	auto messagesCount = quint32();
+	stream >> messagesCount;
+	if (!stream.ok() || messagesCount > kSliceLimit) {
+		return std::nullopt;
+	}
+	auto result = Slice();
+	result.messages.reserve(messagesCount);
+	for (auto i = 0; i != int(messagesCount); ++i) {
+		auto id = qint64();
+		auto bytes = QByteArray();
+		auto count = quint32();
+		stream >> id >> bytes >> count;
+		if (!stream.ok() || count > 16) {
+			return std::nullopt;
+		}
+		auto message = Message{ .id = MsgId(id), .serialized = bytes };
+		message.peers.reserve(count);
+		for (auto j = 0; j != int(count); ++j) {
+			auto peer = quint64();
+			stream >> peer;
+			message.peers.push_back(DeserializePeerId(peer));
+		}
+		if (!stream.ok()) {
+			return std::nullopt;
+		}
+		result.messages.push_back(std::move(message));
+	}
+	return result;
+}
+
+} // namespace Data
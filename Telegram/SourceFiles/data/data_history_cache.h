@@ -0,0 +1,97 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/timer.h"
+
+class History;
+
+namespace Data {
+
+class Session;
+
+// Raw server messages for the local cache database, empty if too large.
+[[nodiscard]] QByteArray SerializeMessage(const MTPMessage &message);
+[[nodiscard]] std::optional<MTPMessage> DeserializeMessage(
+	const QByteArray &bytes);
+void CollectMessagePeers(
+	const MTPMessage &message,
+	std::vector<PeerId> &peers);
+
+// Messages of other chats use ids shared by the whole account, so their
+// deletion may come without the chat, they are stored with another tag.
+[[nodiscard]] uint8 MessagesCacheTag(PeerId peerId);
+
+// Keeps the newest messages of opened chats in the local cache database,
+// so that a chat can be painted before the first server slice arrives.
+// Everything shown from here is replaced once the server slice is applied.
+class HistoryCache final {
+public:
+	explicit HistoryCache(not_null<Session*> owner);
+	~HistoryCache();
+
+	[[nodiscard]] static bool Enabled();
+
+	// The newest slice as it was received from the server.
+	void rememberSlice(
+		not_null<History*> history,
+		const QVector<MTPMessage> &messages);
+	void rememberNew(PeerId peerId, const MTPMessage &message);
+	void rememberEdited(PeerId peerId, const MTPMessage &message);
+	void forget(PeerId peerId, const QVector<MTPint> &ids);
+	void forget(FullMsgId itemId);
+	void forgetAll(PeerId peerId);
+
+	// A message was deleted in a chat we don't know, it could be cached.
+	void forgetNonChannel(MsgId msgId);
+
+	// The callback may be called synchronously, with an empty list
+	// if nothing is cached for this chat.
+	void load(
+		not_null<History*> history,
+		Fn<void(QVector<MTPMessage>&&)> done);
+
+private:
+	struct Message {
+		MsgId id = 0;
+		QByteArray serialized;
+		std::vector<PeerId> peers;
+	};
+	struct Slice {
+		std::vector<Message> messages;
+	};
+
+	[[nodiscard]] static std::optional<Message> Prepare(
+		const MTPMessage &message);
+	[[nodiscard]] static QVector<MTPMessage> Parse(const Slice &slice);
+
+	void insert(not_null<Slice*> slice, Message &&message);
+	void writeDelayed(PeerId peerId);
+	void clear();
+	void writePending();
+	[[nodiscard]] QByteArray serialize(
+		PeerId peerId,
+		const Slice &slice) const;
+	[[nodiscard]] std::optional<Slice> deserialize(
+		const QByteArray &serialized) const;
+
+	const not_null<Session*> _owner;
+
+	base::flat_map<PeerId, Slice> _slices;
+	base::flat_set<PeerId> _writePending;
+	base::flat_set<PeerId> _loading;
+	base::Timer _writeTimer;
+
+	// Slices of other chats may be on disk without being read yet.
+	bool _nonChannelStoredUnknown = true;
+
+	rpl::lifetime _lifetime;
+
+};
+
+} // namespace Data
@@ -0,0 +1,117 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_messages_index.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kMinCapacity = 16;
+
+[[nodiscard]] uint64 Hash(int64 id) {
+	auto result = uint64(id);
+	result ^= result >> 33;
+	result *= 0xFF51AFD7ED558CCDULL;
+	result ^= result >> 33;
+	return result;
+}
+
+} // namespace
+
+MessagesIndex::MessagesIndex(MessagesIndex &&other)
+: _entries(base::take(other._entries))
+, _capacity(base::take(other._capacity))
+, _size(base::take(other._size)) {
+}
+
+MessagesIndex &MessagesIndex::operator=(MessagesIndex &&other) {
+	_entries = base::take(other._entries);
+	_capacity = base::take(other._capacity);
+	_size = base::take(other._size);
+	return *this;
+}
+
+MessagesIndex::~MessagesIndex() = default;
+
+int MessagesIndex::indexOf(int64 id) const {
+	Expects(_capacity > 0);
+
+	const auto mask = _capacity - 1;
+	auto index = int(Hash(id) & mask);
+	while (_entries[index].item && _entries[index].id != id) {
+		index = (index + 1) & mask;
+	}
+	return index;
+}
+
+HistoryItem *MessagesIndex::lookup(MsgId id) const {
+	return _size ? _entries[indexOf(id.bare)].item : nullptr;
+}
+
+bool MessagesIndex::insert(MsgId id, not_null<HistoryItem*> item) {
+	// Keep the load factor under 3/4 to have short probe sequences.
+	if ((_size + 1) * 4 > _capacity * 3) {
+		rehash(std::max(_capacity * 2, kMinCapacity));
+	}
+	auto &entry = _entries[indexOf(id.bare)];
+	if (entry.item) {
+		return false;
+	}
+	entry = { id.bare, item.get() };
+	++_size;
+	return true;
+}
+
+HistoryItem *MessagesIndex::take(MsgId id) {
+	if (!_size) {
+		return nullptr;
+	}
+	const auto mask = _capacity - 1;
+	auto index = indexOf(id.bare);
+	const auto result = _entries[index].item;
+	if (!result) {
+		return nullptr;
+	}
+
+	// Move back the entries that were placed after the removed one,
+	// so that lookups never stop at a hole inside a probe sequence.
+	auto next = index;
+	while (true) {
+		next = (next + 1) & mask;
+		const auto &entry = _entries[next];
+		if (!entry.item) {
+			break;
+		}
+		const auto ideal = int(Hash(entry.id) & mask);
+		const auto fromIdeal = (next - ideal) & mask;
+		const auto fromHole = (next - index) & mask;
+		if (fromIdeal >= fromHole) {
+			_entries[index] = entry;
+			index = next;
+		}
+	}
+	_entries[index] = Entry();
+	if (!--_size) {
+		_entries = nullptr;
+		_capacity = 0;
+	}
+	return result;
+}
+
+void MessagesIndex::rehash(int capacity) {
+	Expects(capacity > 0 && !(capacity & (capacity - 1)));
+
+	auto was = std::exchange(_entries, std::make_unique<Entry[]>(capacity));
+	const auto wasCapacity = std::exchange(_capacity, capacity);
+	for (auto i = 0; i != wasCapacity; ++i) {
+		if (const auto &entry = was[i]; entry.item) {
+			_entries[indexOf(entry.id)] = entry;
+		}
+	}
+}
+
+} // namespace Data
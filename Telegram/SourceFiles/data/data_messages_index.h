@@ -0,0 +1,52 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+class HistoryItem;
+
+namespace Data {
+
+// Open addressing map from message id to item, with linear probing and
+// backward shift deletion. An entry takes two words instead of a separate
+// heap node for each message, as std::unordered_map would.
+class MessagesIndex final {
+public:
+	MessagesIndex() = default;
+	MessagesIndex(MessagesIndex &&other);
+	MessagesIndex &operator=(MessagesIndex &&other);
+	~MessagesIndex();
+
+	[[nodiscard]] HistoryItem *lookup(MsgId id) const;
+
+	// Returns false if there already is an item with this id.
+	bool insert(MsgId id, not_null<HistoryItem*> item);
+	HistoryItem *take(MsgId id);
+
+	[[nodiscard]] int size() const {
+		return _size;
+	}
+	[[nodiscard]] bool empty() const {
+		return !_size;
+	}
+
+private:
+	struct Entry {
+		int64 id = 0;
+		HistoryItem *item = nullptr;
+	};
+
+	[[nodiscard]] int indexOf(int64 id) const;
+	void rehash(int capacity);
+
+	std::unique_ptr<Entry[]> _entries;
+	int _capacity = 0;
+	int _size = 0;
+
+};
+
+} // namespace Data
@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "data/data_session.h"
 
+#include "main/main_account.h"
 #include "main/main_session.h"
 #include "main/main_session_settings.h"
 #include "main/main_app_config.h"
@@ -18,6 +19,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/application.h"
 #include "core/core_settings.h"
 #include "core/mime_type.h" // Core::IsMimeSticker
+#include "core/tracing.h"
 #include "ui/image/image_location_factory.h" // Images::FromPhotoSize
 #include "ui/text/format_values.h" // Ui::FormatPhone
 #include "export/export_manager.h"
@@ -69,6 +71,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_streaming.h"
 #include "data/data_media_rotation.h"
 #include "data/data_histories.h"
+#include "data/data_history_cache.h"
+#include "data/data_shared_media_cache.h"
 #include "data/data_peer_values.h"
 #include "data/data_premium_limits.h"
 #include "data/data_forum.h"
@@ -233,10 +237,9 @@ Session::Session(not_null<Main::Session*> session)
 	maxPinnedChatsLimitValue(nullptr))
 , _contactsList(Dialogs::SortMode::Name)
 , _contactsNoChatsList(Dialogs::SortMode::Name)
-, _ttlCheckTimer([=] { checkTTLs(); })
+, _expirationsTimer([=] { checkExpirations(); })
 , _selfDestructTimer([=] { checkSelfDestructItems(); })
 , _pollsClosingTimer([=] { checkPollsClosings(); })
-, _watchForOfflineTimer([=] { checkLocalUsersWentOffline(); })
 , _groups(this)
 , _chatsFilters(std::make_unique<ChatFilters>(this))
 , _cloudThemes(std::make_unique<CloudThemes>(session))
@@ -244,6 +247,8 @@ Session::Session(not_null<Main::Session*> session)
 , _streaming(std::make_unique<Streaming>(this))
 , _mediaRotation(std::make_unique<MediaRotation>())
 , _histories(std::make_unique<Histories>(this))
+, _historyCache(std::make_unique<HistoryCache>(this))
+, _sharedMediaCache(std::make_unique<SharedMediaCache>(this))
 , _stickers(std::make_unique<Stickers>(this))
 , _reactions(std::make_unique<Reactions>(this))
 , _emojiStatuses(std::make_unique<EmojiStatuses>(this))
@@ -255,6 +260,10 @@ Session::Session(not_null<Main::Session*> session)
 , _chatbots(std::make_unique<Chatbots>(this))
 , _businessInfo(std::make_unique<BusinessInfo>(this))
 , _shortcutMessages(std::make_unique<ShortcutMessages>(this)) {
+	const auto span = Tracing::Span(
+		"Data::Session setup",
+		_session->account().index());
+
 	_cache->open(_session->local().cacheKey());
 	_bigFileCache->open(_session->local().cacheBigFileKey());
 
@@ -1125,56 +1134,21 @@ void Session::watchForOffline(not_null<UserData*> user, TimeId now) {
 	if (!Data::IsUserOnline(user, now)) {
 		return;
 	}
-	const auto lastseen = user->lastseen();
-	const auto till = lastseen.onlineTill();
-	const auto &[i, ok] = _watchingForOffline.emplace(user, till);
-	if (!ok) {
-		if (i->second == till) {
-			return;
-		}
-		i->second = till;
-	}
-	const auto timeout = Data::OnlineChangeTimeout(lastseen, now);
-	const auto fires = _watchForOfflineTimer.isActive()
-		? _watchForOfflineTimer.remainingTime()
-		: -1;
-	if (fires >= 0 && fires <= timeout) {
-		return;
+	const auto till = user->lastseen().onlineTill();
+	const auto timeout = Data::OnlineChangeTimeout(user, now);
+	const auto when = (till > now)
+		? till
+		: (now + std::max(TimeId(timeout / crl::time(1000)), TimeId(1)));
+	if (_expirations.schedule(user, when)) {
+		scheduleNextExpiration();
 	}
-	_watchForOfflineTimer.callOnce(std::max(timeout, crl::time(1)));
 }
 
 void Session::maybeStopWatchForOffline(not_null<UserData*> user) {
 	if (Data::IsUserOnline(user)) {
 		return;
-	} else if (_watchingForOffline.remove(user)
-		&& _watchingForOffline.empty()) {
-		_watchForOfflineTimer.cancel();
-	}
-}
-
-void Session::checkLocalUsersWentOffline() {
-	_watchForOfflineTimer.cancel();
-
-	auto minimal = 86400 * crl::time(1000);
-	const auto now = base::unixtime::now();
-	for (auto i = begin(_watchingForOffline)
-		; i != end(_watchingForOffline);) {
-		const auto user = i->first;
-		if (!Data::IsUserOnline(user, now)) {
-			i = _watchingForOffline.erase(i);
-			session().changes().peerUpdated(
-				user,
-				PeerUpdate::Flag::OnlineStatus);
-		} else {
-			const auto timeout = Data::OnlineChangeTimeout(user, now);
-			accumulate_min(minimal, timeout);
-			++i;
-		}
-	}
-	if (!_watchingForOffline.empty()) {
-		_watchForOfflineTimer.callOnce(std::max(minimal, crl::time(1)));
 	}
+	_expirations.cancel(user);
 }
 
 auto Session::invitedToCallUsers(CallId callId) const
@@ -1657,22 +1631,19 @@ rpl::producer<not_null<HistoryItem*>> Session::newItemAdded() const {
 
 HistoryItem *Session::changeMessageId(PeerId peerId, MsgId wasId, MsgId nowId) {
 	const auto list = messagesListForInsert(peerId);
-	const auto i = list->find(wasId);
-	if (i == list->end()) {
+	const auto item = list->take(wasId);
+	if (!item) {
 		return nullptr;
 	}
-	const auto item = i->second;
-	list->erase(i);
-	const auto &[j, ok] = list->emplace(nowId, item);
+	const auto ok = list->insert(nowId, item);
 
 	if (!peerIsChannel(peerId)) {
 		if (IsServerMsgId(wasId)) {
-			const auto k = _nonChannelMessages.find(wasId);
-			Assert(k != end(_nonChannelMessages));
-			_nonChannelMessages.erase(k);
+			const auto removed = _nonChannelMessages.take(wasId);
+			Assert(removed == item);
 		}
 		if (IsServerMsgId(nowId)) {
-			_nonChannelMessages.emplace(nowId, item);
+			_nonChannelMessages.insert(nowId, item);
 		}
 	}
 
@@ -1921,6 +1892,7 @@ rpl::producer<not_null<const ViewElement*>> Session::viewPaidReactionSent() cons
 }
 
 void Session::notifyHistoryUnloaded(not_null<const History*> history) {
+	_chatsFilters->forgetRules(history);
 	_historyUnloaded.fire_copy(history);
 }
 
@@ -1929,6 +1901,8 @@ rpl::producer<not_null<const History*>> Session::historyUnloaded() const {
 }
 
 void Session::notifyHistoryCleared(not_null<const History*> history) {
+	_historyCache->forgetAll(history->peer->id);
+	_sharedMediaCache->forget(history->peer->id);
 	_historyCleared.fire_copy(history);
 }
 
@@ -1960,11 +1934,25 @@ rpl::producer<> Session::pinnedDialogsOrderUpdated() const {
 }
 
 void Session::registerHeavyViewPart(not_null<ViewElement*> view) {
-	_heavyViewParts.emplace(view);
+	if (_heavyViewParts.emplace(view).second) {
+		_heavyViewPartAdded.fire_copy(view);
+	}
 }
 
 void Session::unregisterHeavyViewPart(not_null<ViewElement*> view) {
-	_heavyViewParts.remove(view);
+	if (_heavyViewParts.remove(view)) {
+		_heavyViewPartRemoved.fire_copy(view);
+	}
+}
+
+auto Session::heavyViewPartAdded() const
+-> rpl::producer<not_null<ViewElement*>> {
+	return _heavyViewPartAdded.events();
+}
+
+auto Session::heavyViewPartRemoved() const
+-> rpl::producer<not_null<ViewElement*>> {
+	return _heavyViewPartRemoved.events();
 }
 
 void Session::unloadHeavyViewParts(
@@ -1978,6 +1966,7 @@ void Session::unloadHeavyViewParts(
 		[](not_null<ViewElement*> element) { return element->delegate(); });
 	if (remove == _heavyViewParts.size()) {
 		for (const auto &view : base::take(_heavyViewParts)) {
+			_heavyViewPartRemoved.fire_copy(view);
 			view->unloadHeavyPart();
 		}
 	} else {
@@ -2362,6 +2351,7 @@ void Session::updateEditedMessage(const MTPMessage &data) {
 		Reactions::CheckUnknownForUnread(this, data);
 		return;
 	}
+	_historyCache->rememberEdited(existing->history()->peer->id, data);
 
 	// AyuGram saveMessagesHistory
 	const auto settings = &AyuSettings::getInstance();
@@ -2461,42 +2451,23 @@ void Session::registerMessage(not_null<HistoryItem*> item) {
 	const auto list = messagesListForInsert(peerId);
 	const auto itemId = item->id;
 
-	const auto i = list->find(itemId);
-	if (i != list->end()) {
+	if (const auto existing = list->lookup(itemId)) {
 		LOG(("App Error: Trying to re-registerMessage()."));
-		i->second->destroy();
+		existing->destroy();
 	}
-	list->emplace(itemId, item);
+	list->insert(itemId, item);
 
 	if (!peerIsChannel(peerId) && IsServerMsgId(itemId)) {
-		_nonChannelMessages.emplace(itemId, item);
+		_nonChannelMessages.insert(itemId, item);
 	}
 }
 
 void Session::registerMessageTTL(TimeId when, not_null<HistoryItem*> item) {
 	Expects(when > 0);
 
-	auto &list = _ttlMessages[when];
-	list.emplace(item);
-
-	const auto nearest = _ttlMessages.begin()->first;
-	if (nearest < when && _ttlCheckTimer.isActive()) {
-		return;
+	if (_expirations.schedule(item, when)) {
+		scheduleNextExpiration();
 	}
-	scheduleNextTTLs();
-}
-
-void Session::scheduleNextTTLs() {
-	if (_ttlMessages.empty()) {
-		return;
-	}
-	const auto nearest = _ttlMessages.begin()->first;
-	const auto now = base::unixtime::now();
-
-	// Set timer not more than for 24 hours.
-	const auto maxTimeout = TimeId(86400);
-	const auto timeout = std::min(std::max(now, nearest) - now, maxTimeout);
-	_ttlCheckTimer.callOnce(timeout * crl::time(1000));
 }
 
 void Session::unregisterMessageTTL(
@@ -2504,45 +2475,72 @@ void Session::unregisterMessageTTL(
 		not_null<HistoryItem*> item) {
 	Expects(when > 0);
 
-	const auto i = _ttlMessages.find(when);
-	if (i == end(_ttlMessages)) {
+	_expirations.cancel(item);
+}
+
+std::size_t Session::ExpiringHash::operator()(const Expiring &value) const {
+	return v::match(value, [](const auto &pointer) {
+		return std::hash<const void*>()(pointer.get());
+	});
+}
+
+void Session::scheduleNextExpiration() {
+	const auto tick = _expirations.nextTick();
+	if (!tick) {
+		_expirationsTimer.cancel();
+		return;
+	} else if (_expirationsTimer.isActive() && _expirationsTick <= *tick) {
 		return;
 	}
-	auto &list = i->second;
-	list.erase(item);
-	if (list.empty()) {
-		_ttlMessages.erase(i);
-	}
-}
+	_expirationsTick = *tick;
 
-void Session::checkTTLs() {
-	const auto settings = &AyuSettings::getInstance();
+	// Set timer not more than for 24 hours.
+	const auto maxTimeout = TimeId(86400);
+	const auto now = base::unixtime::now();
+	const auto timeout = std::min(std::max(now, *tick) - now, maxTimeout);
+	_expirationsTimer.callOnce(timeout * crl::time(1000));
+}
 
-	_ttlCheckTimer.cancel();
+void Session::checkExpirations() {
 	const auto now = base::unixtime::now();
+	auto items = std::vector<FullMsgId>();
+	auto users = std::vector<not_null<UserData*>>();
+	for (const auto &key : _expirations.advance(now)) {
+		v::match(key, [&](not_null<HistoryItem*> item) {
+			items.push_back(item->fullId());
+		}, [&](not_null<UserData*> user) {
+			users.push_back(user);
+		});
+	}
 
-	if (settings->saveDeletedMessages) {
-		auto toBeRemoved = ranges::views::take_while(
-			_ttlMessages,
-			[now](const auto &pair) {
-				return pair.first <= now;
-			}) | ranges::views::transform([](const auto &pair) {
-				return pair.second;
-			}) | ranges::views::join;
-		for (auto &item : toBeRemoved) {
-			item->setAyuHint(settings->deletedMark);
+	// Destroying one item may destroy others, so find them by id.
+	const auto settings = &AyuSettings::getInstance();
+	for (const auto &id : items) {
+		if (const auto item = message(id)) {
+			if (settings->saveDeletedMessages) {
+				item->setAyuHint(settings->deletedMark);
+			} else {
+				item->destroy();
+			}
 		}
-	} else {
-		while (!_ttlMessages.empty() && _ttlMessages.begin()->first <= now) {
-			_ttlMessages.begin()->second.front()->destroy();
+	}
+	for (const auto &user : users) {
+		if (Data::IsUserOnline(user, now)) {
+			watchForOffline(user, now);
+		} else {
+			session().changes().peerUpdated(
+				user,
+				PeerUpdate::Flag::OnlineStatus);
 		}
 	}
-	scheduleNextTTLs();
+	scheduleNextExpiration();
 }
 
 void Session::processMessagesDeleted(
 		PeerId peerId,
 		const QVector<MTPint> &data) {
+	_historyCache->forget(peerId, data);
+
 	const auto list = messagesList(peerId);
 	const auto affected = historyLoaded(peerId);
 	if (!list && !affected) {
@@ -2551,15 +2549,15 @@ void Session::processMessagesDeleted(
 
 	auto historiesToCheck = base::flat_set<not_null<History*>>();
 	for (const auto &messageId : data) {
-		const auto i = list ? list->find(messageId.v) : Messages::iterator();
-		if (list && i != list->end()) {
-			const auto history = i->second->history();
+		const auto item = list ? list->lookup(messageId.v) : nullptr;
+		if (item) {
+			const auto history = item->history();
 
 			const auto settings = &AyuSettings::getInstance();
 			if (!settings->saveDeletedMessages) {
-				i->second->destroy();
+				item->destroy();
 			} else {
-				i->second->setAyuHint(settings->deletedMark);
+				item->setAyuHint(settings->deletedMark);
 			}
 
 			if (!history->chatListMessageKnown()) {
@@ -2579,6 +2577,7 @@ void Session::processNonChannelMessagesDeleted(const QVector<MTPint> &data) {
 	for (const auto &messageId : data) {
 		if (const auto item = nonChannelMessage(messageId.v)) {
 			const auto history = item->history();
+			_historyCache->forget(item->fullId());
 
 			const auto settings = &AyuSettings::getInstance();
 			if (!settings->saveDeletedMessages) {
@@ -2590,6 +2589,8 @@ void Session::processNonChannelMessagesDeleted(const QVector<MTPint> &data) {
 			if (!history->chatListMessageKnown()) {
 				historiesToCheck.emplace(history);
 			}
+		} else {
+			_historyCache->forgetNonChannel(messageId.v);
 		}
 	}
 	for (const auto &history : historiesToCheck) {
@@ -2635,10 +2636,10 @@ void Session::unregisterMessage(not_null<HistoryItem*> item) {
 			++i;
 		}
 	}
-	messagesListForInsert(peerId)->erase(itemId);
+	messagesListForInsert(peerId)->take(itemId);
 
 	if (!peerIsChannel(peerId) && IsServerMsgId(itemId)) {
-		_nonChannelMessages.erase(itemId);
+		_nonChannelMessages.take(itemId);
 	}
 }
 
@@ -2672,8 +2673,7 @@ HistoryItem *Session::message(PeerId peerId, MsgId itemId) const {
 		return nullptr;
 	}
 
-	const auto i = data->find(itemId);
-	return (i != data->end()) ? i->second.get() : nullptr;
+	return data->lookup(itemId);
 }
 
 HistoryItem *Session::message(
@@ -2690,8 +2690,7 @@ HistoryItem *Session::nonChannelMessage(MsgId itemId) const {
 	if (!IsServerMsgId(itemId)) {
 		return nullptr;
 	}
-	const auto i = _nonChannelMessages.find(itemId);
-	return (i != end(_nonChannelMessages)) ? i->second.get() : nullptr;
+	return _nonChannelMessages.lookup(itemId);
 }
 
 void Session::updateDependentMessages(not_null<HistoryItem*> item) {
@@ -2776,6 +2775,7 @@ HistoryItem *Session::addNewMessage(
 		type);
 	if (type == NewMessageType::Unread) {
 		CheckForSwitchInlineButton(result);
+		_historyCache->rememberNew(peerId, data);
 	}
 	return result;
 }
@@ -4516,6 +4516,8 @@ void Session::refreshChatListEntry(Dialogs::Key key) {
 	if (!history) {
 		return;
 	}
+	const auto rules = ChatFilter::RulesFor(history);
+	const auto recheck = _chatsFilters->rememberRules(history, rules);
 	for (const auto &filter : _chatsFilters->list()) {
 		const auto id = filter.id();
 		if (!id) {
@@ -4523,7 +4525,11 @@ void Session::refreshChatListEntry(Dialogs::Key key) {
 		}
 		const auto filterList = chatsFilters().chatsList(id);
 		auto event = ChatListEntryRefresh{ .key = key, .filterId = id };
-		if (filter.contains(history)) {
+		if (!recheck) {
+			if (entry->inChatList(id)) {
+				event.moved = entry->adjustByPosInChatList(id, filterList);
+			}
+		} else if (filter.contains(history, rules)) {
 			event.existenceChanged = !entry->inChatList(id);
 			if (event.existenceChanged) {
 				entry->addToChatList(id, filterList);
@@ -4560,6 +4566,9 @@ void Session::removeChatListEntry(Dialogs::Key key) {
 	}
 	Assert(entry->folderKnown());
 
+	if (const auto history = key.history()) {
+		_chatsFilters->forgetRules(history);
+	}
 	for (const auto &filter : _chatsFilters->list()) {
 		const auto id = filter.id();
 		if (id && entry->inChatList(id)) {
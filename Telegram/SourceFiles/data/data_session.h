@@ -11,8 +11,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "dialogs/dialogs_main_list.h"
 #include "data/data_groups.h"
 #include "data/data_cloud_file.h"
+#include "data/data_messages_index.h"
+#include "data/data_timer_wheel.h"
 #include "history/history_location_manager.h"
 #include "base/timer.h"
+#include "base/variant.h"
 
 class Image;
 class HistoryItem;
@@ -58,6 +61,8 @@ class CloudThemes;
 class Streaming;
 class MediaRotation;
 class Histories;
+class HistoryCache;
+class SharedMediaCache;
 class DocumentMedia;
 class PhotoMedia;
 class Stickers;
@@ -122,6 +127,12 @@ public:
 	[[nodiscard]] Histories &histories() const {
 		return *_histories;
 	}
+	[[nodiscard]] HistoryCache &historyCache() const {
+		return *_historyCache;
+	}
+	[[nodiscard]] SharedMediaCache &sharedMediaCache() const {
+		return *_sharedMediaCache;
+	}
 	[[nodiscard]] Stickers &stickers() const {
 		return *_stickers;
 	}
@@ -327,6 +338,10 @@ public:
 
 	void registerHeavyViewPart(not_null<ViewElement*> view);
 	void unregisterHeavyViewPart(not_null<ViewElement*> view);
+	[[nodiscard]] auto heavyViewPartAdded() const
+		-> rpl::producer<not_null<ViewElement*>>;
+	[[nodiscard]] auto heavyViewPartRemoved() const
+		-> rpl::producer<not_null<ViewElement*>>;
 	void unloadHeavyViewParts(
 		not_null<HistoryView::ElementDelegate*> delegate);
 	void unloadHeavyViewParts(
@@ -776,7 +791,13 @@ public:
 	void clearLocalStorage();
 
 private:
-	using Messages = std::unordered_map<MsgId, not_null<HistoryItem*>>;
+	using Messages = MessagesIndex;
+	using Expiring = std::variant<
+		not_null<HistoryItem*>,
+		not_null<UserData*>>;
+	struct ExpiringHash {
+		std::size_t operator()(const Expiring &value) const;
+	};
 
 	void suggestStartExport();
 
@@ -786,10 +807,8 @@ private:
 	void setupUserIsContactViewer();
 
 	void checkSelfDestructItems();
-	void checkLocalUsersWentOffline();
-
-	void scheduleNextTTLs();
-	void checkTTLs();
+	void scheduleNextExpiration();
+	void checkExpirations();
 
 	int computeUnreadBadge(const Dialogs::UnreadState &state) const;
 	bool computeUnreadBadgeMuted(const Dialogs::UnreadState &state) const;
@@ -954,10 +973,11 @@ private:
 	std::map<
 		not_null<HistoryItem*>,
 		base::flat_set<not_null<HistoryItem*>>> _dependentMessages;
-	std::map<TimeId, base::flat_set<not_null<HistoryItem*>>> _ttlMessages;
-	base::Timer _ttlCheckTimer;
+	TimerWheel<Expiring, ExpiringHash> _expirations;
+	base::Timer _expirationsTimer;
+	TimeId _expirationsTick = 0;
 
-	std::unordered_map<MsgId, not_null<HistoryItem*>> _nonChannelMessages;
+	MessagesIndex _nonChannelMessages;
 
 	base::flat_map<uint64, FullMsgId> _messageByRandomId;
 	base::flat_map<uint64, SentData> _sentMessagesData;
@@ -1042,6 +1062,8 @@ private:
 	rpl::event_stream<> _pinnedDialogsOrderUpdated;
 
 	base::flat_set<not_null<ViewElement*>> _heavyViewParts;
+	rpl::event_stream<not_null<ViewElement*>> _heavyViewPartAdded;
+	rpl::event_stream<not_null<ViewElement*>> _heavyViewPartRemoved;
 
 	base::flat_map<uint64, not_null<GroupCall*>> _groupCalls;
 	rpl::event_stream<InviteToCall> _invitesToCalls;
@@ -1068,9 +1090,6 @@ private:
 	std::vector<WallPaper> _wallpapers;
 	uint64 _wallpapersHash = 0;
 
-	base::flat_map<not_null<UserData*>, TimeId> _watchingForOffline;
-	base::Timer _watchForOfflineTimer;
-
 	base::flat_map<not_null<PeerData*>, MTP::DcId> _peerStatsDcIds;
 
 	rpl::event_stream<WebViewResultSent> _webViewResultSent;
@@ -1087,6 +1106,8 @@ private:
 	const std::unique_ptr<Streaming> _streaming;
 	const std::unique_ptr<MediaRotation> _mediaRotation;
 	const std::unique_ptr<Histories> _histories;
+	const std::unique_ptr<HistoryCache> _historyCache;
+	const std::unique_ptr<SharedMediaCache> _sharedMediaCache;
 	const std::unique_ptr<Stickers> _stickers;
 	const std::unique_ptr<Reactions> _reactions;
 	const std::unique_ptr<EmojiStatuses> _emojiStatuses;
@@ -0,0 +1,320 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_shared_media_cache.h"
+
+#include "data/data_channel.h"
+#include "data/data_history_cache.h"
+#include "data/data_search_controller.h"
+#include "data/data_session.h"
+#include "history/history_item.h"
+#include "history/history_item_edition.h"
+#include "main/main_session.h"
+#include "storage/cache/storage_cache_database.h"
+#include "storage/serialize_common.h"
+#include "storage/serialize_peer.h"
+#include "storage/storage_facade.h"
+#include "storage/storage_shared_media.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kMaxPageSize = 200;
+
+} // namespace
+
+SharedMediaCache::SharedMediaCache(not_null<Session*> owner)
+: _owner(owner) {
+}
+
+SharedMediaCache::~SharedMediaCache() = default;
+
+bool SharedMediaCache::IsNewestPage(MsgId topicRootId, MsgId aroundId) {
+	return !topicRootId && (aroundId >= ServerMaxMsgId - 1);
+}
+
+void SharedMediaCache::remember(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		const MTPmessages_Messages &result,
+		const Api::SearchResult &parsed) {
+	if (!HistoryCache::Enabled()) {
+		return;
+	}
+	const auto key = SharedMediaCacheKey(peer->id, int(type));
+	result.match([&](const MTPDmessages_messagesNotModified &) {
+	}, [&](const auto &data) {
+		const auto &messages = data.vmessages().v;
+		if (parsed.messageIds.empty() || messages.size() > kMaxPageSize) {
+			_owner->cache().remove(key);
+		} else {
+			_owner->cache().put(key, Storage::Cache::Database::TaggedValue(
+				serialize(peer, parsed, messages),
+				MessagesCacheTag(peer->id)));
+		}
+	});
+}
+
+void SharedMediaCache::forget(PeerId peerId) {
+	for (auto i = 0; i != Storage::kSharedMediaTypeCount; ++i) {
+		_owner->cache().remove(SharedMediaCacheKey(peerId, i));
+	}
+}
+
+void SharedMediaCache::replaceProvisional(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		const MTPmessages_Messages &result,
+		const Api::SearchResult &parsed) {
+	const auto i = _provisional.find(std::make_pair(peer->id, type));
+	if (i == end(_provisional)) {
+		return;
+	}
+	const auto provisional = std::move(i->second);
+	_provisional.erase(i);
+
+	// Existing items are not updated from the server messages,
+	// so apply the fresh version to the ones built from the cache.
+	result.match([&](const MTPDmessages_messagesNotModified &) {
+	}, [&](const auto &data) {
+		for (const auto &message : data.vmessages().v) {
+			const auto id = IdFromMessage(message);
+			if (!provisional.created.contains(id)) {
+				continue;
+			}
+			const auto item = _owner->message(peer->id, id);
+			if (!item) {
+				continue;
+			}
+			message.match([](const MTPDmessageEmpty &) {
+			}, [&](const MTPDmessageService &data) {
+				item->applyEdition(data);
+			}, [&](const MTPDmessage &data) {
+				item->applyEdition(HistoryMessageEdition(
+					&_owner->session(),
+					data));
+			});
+		}
+	});
+
+	const auto &range = parsed.noSkipRange;
+	for (const auto id : provisional.messageIds) {
+		if (id < range.from
+			|| id > range.till
+			|| ranges::contains(parsed.messageIds, id)) {
+			continue;
+		}
+		_owner->session().storage().remove(Storage::SharedMediaRemoveOne(
+			peer->id,
+			type,
+			id));
+
+		// The message was deleted or lost its media while we were away.
+		// If we created it only to show the cached page, drop it as well.
+		if (provisional.created.contains(id)) {
+			if (const auto item = _owner->message(peer->id, id)) {
+				if (!item->mainView()) {
+					item->destroy();
+				}
+			}
+		}
+	}
+}
+
+void SharedMediaCache::apply(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		Fn<void(bool fresh)> done) {
+	const auto key = std::make_pair(peer->id, type);
+	if (!HistoryCache::Enabled() || _applied.contains(key)) {
+		done(false);
+		return;
+	}
+	_applied.emplace(key);
+	const auto weak = base::make_weak(&_owner->session());
+	_owner->cache().get(SharedMediaCacheKey(peer->id, int(type)), [=](
+			QByteArray &&value) {
+		crl::on_main(weak, [=, value = std::move(value)] {
+			auto page = value.isEmpty()
+				? std::optional<Page>()
+				: deserialize(value);
+			if (!page) {
+				done(false);
+				return;
+			}
+			applyPage(peer, type, std::move(*page), done);
+		});
+	});
+}
+
+void SharedMediaCache::applyPage(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		Page &&page,
+		Fn<void(bool fresh)> done) {
+	auto created = base::flat_set<MsgId>();
+	for (const auto &message : page.messages) {
+		const auto id = IdFromMessage(message);
+		const auto existed = (_owner->message(peer->id, id) != nullptr);
+		_owner->addNewMessage(
+			message,
+			MessageFlags(),
+			NewMessageType::Existing);
+		if (!existed) {
+			created.emplace(id);
+		}
+	}
+	const auto known = ranges::all_of(page.messageIds, [&](MsgId id) {
+		const auto item = _owner->message(peer->id, id);
+		return item && item->sharedMediaTypes().test(type);
+	});
+	if (!known) {
+		done(false);
+		return;
+	}
+	const auto fresh = page.pts && (page.pts == currentPts(peer));
+	if (!fresh) {
+		_provisional[std::make_pair(peer->id, type)] = Provisional{
+			.messageIds = page.messageIds,
+			.created = std::move(created),
+		};
+	}
+	_owner->session().storage().add(Storage::SharedMediaAddSlice(
+		peer->id,
+		MsgId(0),
+		type,
+		std::move(page.messageIds),
+		page.noSkipRange,
+		page.fullCount));
+	done(fresh);
+}
+
+int32 SharedMediaCache::currentPts(not_null<PeerData*> peer) const {
+	// Other peers share the account pts, which moves with every update,
+	// so their pages can't be checked for freshness and are never fresh.
+	const auto channel = peer->asChannel();
+	return channel ? channel->pts() : 0;
+}
+
+QByteArray SharedMediaCache::serialize(
+		not_null<PeerData*> peer,
+		const Api::SearchResult &parsed,
+		const QVector<MTPMessage> &messages) const {
+	auto serialized = std::vector<QByteArray>();
+	auto peerIds = std::vector<PeerId>{ peer->id };
+	serialized.reserve(messages.size());
+	for (const auto &message : messages) {
+		auto bytes = SerializeMessage(message);
+		if (!bytes.isEmpty()) {
+			serialized.push_back(std::move(bytes));
+			CollectMessagePeers(message, peerIds);
+		}
+	}
+	auto peers = std::vector<not_null<PeerData*>>();
+	peers.reserve(peerIds.size());
+	for (const auto id : peerIds) {
+		if (const auto loaded = _owner->peerLoaded(id)) {
+			peers.push_back(loaded);
+		}
+	}
+
+	auto size = 4 * sizeof(quint32) // AppVersion, pts, count, ids
+		+ 2 * sizeof(qint64) // noSkipRange
+		+ parsed.messageIds.size() * sizeof(qint64)
+		+ 2 * sizeof(quint32); // peers, messages
+	for (const auto &peer : peers) {
+		size += Serialize::peerSize(peer);
+	}
+	for (const auto &bytes : serialized) {
+		size += Serialize::bytearraySize(bytes);
+	}
+
+	auto stream = Serialize::ByteArrayWriter(size);
+	stream
+		<< quint32(AppVersion)
+		<< qint32(currentPts(peer))
+		<< qint32(parsed.fullCount)
+		<< qint64(parsed.noSkipRange.from.bare)
+		<< qint64(parsed.noSkipRange.till.bare)
+		<< quint32(parsed.messageIds.size());
+	for (const auto id : parsed.messageIds) {
+		stream << qint64(id.bare);
+	}
+	stream << quint32(peers.size());
+	for (const auto &peer : peers) {
+		Serialize::writePeer(stream, peer);
+	}
+	stream << quint32(serialized.size());
+	for (const auto &bytes : serialized) {
+		stream << bytes;
+	}
+	return std::move(stream).result();
+}
+
+auto SharedMediaCache::deserialize(const QByteArray &serialized) const
+-> std::optional<Page> {
+	auto stream = Serialize::ByteArrayReader(serialized);
+	auto streamAppVersion = quint32();
+	auto pts = qint32();
+	auto fullCount = qint32();
+	auto from = qint64();
+	auto till = qint64();
+	auto idsCount = quint32();
+	stream
+		>> streamAppVersion
+		>> pts
+		>> fullCount
+		>> from
+		>> till
+		>> idsCount;
+	if (!stream.ok() || idsCount > kMaxPageSize || from > till) {
+		return std::nullopt;
+	}
+	auto result = Page{
+		.pts = pts,
+		.fullCount = fullCount,
+		.noSkipRange = { MsgId(from), MsgId(till) },
+	};
+	result.messageIds.reserve(idsCount);
+	for (auto i = 0; i != int(idsCount); ++i) {
+		auto id = qint64();
+		stream >> id;
+		result.messageIds.push_back(MsgId(id));
+	}
+	auto peersCount = quint32();
+	stream >> peersCount;
+	if (!stream.ok()) {
+		return std::nullopt;
+	}
+	for (auto i = 0; i != int(peersCount); ++i) {
+		const auto peer = Serialize::readPeer(
+			&_owner->session(),
+			streamAppVersion,
+			stream);
+		if (!stream.ok() || !peer) {
+			return std::nullopt;
+		}
+	}
+	auto messagesCount = quint32();
+	stream >> messagesCount;
+	if (!stream.ok() || messagesCount > kMaxPageSize) {
+		return std::nullopt;
+	}
+	result.messages.reserve(messagesCount);
+	for (auto i = 0; i != int(messagesCount); ++i) {
+		auto bytes = QByteArray();
+		stream >> bytes;
+		if (!stream.ok()) {
+			return std::nullopt;
+		} else if (auto message = DeserializeMessage(bytes)) {
+			result.messages.push_back(std::move(*message));
+		}
+	}
+	return result;
+}
+
+} // namespace Data
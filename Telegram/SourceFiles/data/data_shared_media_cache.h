@@ -0,0 +1,89 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Api {
+struct SearchResult;
+} // namespace Api
+
+namespace Storage {
+enum class SharedMediaType : signed char;
+} // namespace Storage
+
+namespace Data {
+
+class Session;
+
+// Keeps the newest page of opened shared media lists in the local cache
+// database together with its messages. A channel page saved with the same
+// pts that the channel has now is used without asking the server again.
+// Other pages are shown provisionally until the server page replaces them.
+class SharedMediaCache final {
+public:
+	explicit SharedMediaCache(not_null<Session*> owner);
+	~SharedMediaCache();
+
+	[[nodiscard]] static bool IsNewestPage(MsgId topicRootId, MsgId aroundId);
+
+	void remember(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		const MTPmessages_Messages &result,
+		const Api::SearchResult &parsed);
+	void forget(PeerId peerId);
+
+	// Removes provisionally shown ids the server page doesn't have
+	// and brings the messages created from the cache up to date.
+	void replaceProvisional(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		const MTPmessages_Messages &result,
+		const Api::SearchResult &parsed);
+
+	// Adds the cached page to the shared media storage, if there is one.
+	// The callback receives true if the page doesn't need a refresh.
+	void apply(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		Fn<void(bool fresh)> done);
+
+private:
+	struct Provisional {
+		std::vector<MsgId> messageIds;
+		base::flat_set<MsgId> created;
+	};
+	struct Page {
+		int32 pts = 0;
+		int fullCount = 0;
+		MsgRange noSkipRange;
+		std::vector<MsgId> messageIds;
+		QVector<MTPMessage> messages;
+	};
+
+	[[nodiscard]] int32 currentPts(not_null<PeerData*> peer) const;
+	[[nodiscard]] QByteArray serialize(
+		not_null<PeerData*> peer,
+		const Api::SearchResult &parsed,
+		const QVector<MTPMessage> &messages) const;
+	[[nodiscard]] std::optional<Page> deserialize(
+		const QByteArray &serialized) const;
+	void applyPage(
+		not_null<PeerData*> peer,
+		Storage::SharedMediaType type,
+		Page &&page,
+		Fn<void(bool fresh)> done);
+
+	const not_null<Session*> _owner;
+
+	using Key = std::pair<PeerId, Storage::SharedMediaType>;
+	base::flat_set<Key> _applied;
+	base::flat_map<Key, Provisional> _provisional;
+
+};
+
+} // namespace Data
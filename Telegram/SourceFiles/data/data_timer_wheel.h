@@ -0,0 +1,183 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/unixtime.h"
+
+namespace Data {
+
+// Hierarchical timer wheel with one second ticks.
+//
+// Each level has 64 slots, an entry is put on the level of the highest
+// 6 bit digit in which its time differs from the current one. When the
+// wheel reaches a slot of an upper level the entries are moved down, so
+// schedule() and cancel() are O(1) and the owner needs a single timer for
+// nextTick(). Cancelled entries are left in slots and skipped later.
+template <typename Key, typename Hash = std::hash<Key>>
+class TimerWheel final {
+public:
+	// Returns false if the key already was scheduled for the same time.
+	bool schedule(Key key, TimeId when) {
+		if (!_now) {
+			_now = base::unixtime::now();
+		}
+		const auto &[i, ok] = _scheduled.emplace(key, when);
+		if (!ok) {
+			if (i->second == when) {
+				return false;
+			}
+			i->second = when;
+		}
+		place({ std::move(key), when }, _due);
+		return true;
+	}
+	bool cancel(const Key &key) {
+		return _scheduled.erase(key) > 0;
+	}
+	[[nodiscard]] bool scheduled(const Key &key) const {
+		return _scheduled.contains(key);
+	}
+	[[nodiscard]] bool empty() const {
+		return _scheduled.empty();
+	}
+
+	// The earliest time at which advance() may have something to do.
+	[[nodiscard]] std::optional<TimeId> nextTick() const {
+		if (_scheduled.empty()) {
+			return std::nullopt;
+		} else if (!_due.empty()) {
+			return _now;
+		}
+		auto result = std::optional<TimeId>();
+		for (auto level = 0; level != kLevels; ++level) {
+			const auto shift = level * kSlotBits;
+			const auto current = Digit(_now, level);
+			for (auto slot = current + 1; slot != kSlots; ++slot) {
+				if (!_slots[level][slot].empty()) {
+					const auto start = (_now >> (shift + kSlotBits))
+						<< (shift + kSlotBits);
+					const auto tick = start + (TimeId(slot) << shift);
+					if (!result || *result > tick) {
+						result = tick;
+					}
+					break;
+				}
+			}
+		}
+		if (!_overflow.empty()) {
+			const auto shift = kLevels * kSlotBits;
+			const auto tick = ((_now >> shift) + 1) << shift;
+			if (!result || *result > tick) {
+				result = tick;
+			}
+		}
+		return result;
+	}
+
+	// Moves the wheel to the given time and returns the expired keys.
+	[[nodiscard]] std::vector<Key> advance(TimeId now) {
+		auto result = std::vector<Key>();
+		collect(base::take(_due), result);
+		while (!_scheduled.empty()) {
+			const auto tick = nextTick();
+			if (!tick || *tick > now) {
+				break;
+			}
+			process(*tick, result);
+		}
+		_now = std::max(_now, now);
+		return result;
+	}
+
+private:
+	struct Entry {
+		Key key;
+		TimeId when = 0;
+	};
+	static constexpr auto kSlotBits = 6;
+	static constexpr auto kSlots = (1 << kSlotBits);
+	static constexpr auto kLevels = 4;
+
+	[[nodiscard]] static int Digit(TimeId time, int level) {
+		return int((time >> (level * kSlotBits)) & (kSlots - 1));
+	}
+
+	[[nodiscard]] bool valid(const Entry &entry) const {
+		const auto i = _scheduled.find(entry.key);
+		return (i != end(_scheduled)) && (i->second == entry.when);
+	}
+
+	void place(Entry &&entry, std::vector<Entry> &due) {
+		if (entry.when <= _now) {
+			due.push_back(std::move(entry));
+			return;
+		}
+		const auto difference = (entry.when ^ _now);
+		auto level = 0;
+		while (level < kLevels
+			&& (difference >> ((level + 1) * kSlotBits))) {
+			++level;
+		}
+		if (level == kLevels) {
+			_overflow.push_back(std::move(entry));
+		} else {
+			const auto slot = Digit(entry.when, level);
+			_slots[level][slot].push_back(std::move(entry));
+		}
+	}
+
+	void process(TimeId tick, std::vector<Key> &result) {
+		_now = tick;
+		auto due = std::vector<Entry>();
+		if (!Digit(tick, 0)) {
+			// Reached a boundary, move entries of upper levels down.
+			auto moved = std::vector<Entry>();
+			if (!(tick & ((TimeId(1) << (kLevels * kSlotBits)) - 1))) {
+				moved = base::take(_overflow);
+			}
+			for (auto level = kLevels; level != 1;) {
+				--level;
+				const auto mask = (TimeId(1) << (level * kSlotBits)) - 1;
+				if (!(tick & mask)) {
+					auto &slot = _slots[level][Digit(tick, level)];
+					for (auto &entry : base::take(slot)) {
+						moved.push_back(std::move(entry));
+					}
+				}
+			}
+			for (auto &entry : moved) {
+				if (valid(entry)) {
+					place(std::move(entry), due);
+				}
+			}
+		}
+		auto &slot = _slots[0][Digit(tick, 0)];
+		for (auto &entry : base::take(slot)) {
+			due.push_back(std::move(entry));
+		}
+		collect(std::move(due), result);
+	}
+
+	void collect(std::vector<Entry> &&due, std::vector<Key> &result) {
+		for (auto &entry : due) {
+			if (valid(entry)) {
+				_scheduled.erase(entry.key);
+				result.push_back(std::move(entry.key));
+			}
+		}
+	}
+
+	std::unordered_map<Key, TimeId, Hash> _scheduled;
+	std::array<std::array<std::vector<Entry>, kSlots>, kLevels> _slots;
+	std::vector<Entry> _overflow;
+	std::vector<Entry> _due;
+	TimeId _now = 0;
+
+};
+
+} // namespace Data
@@ -22,6 +22,9 @@ constexpr auto kAudioAlbumThumbCacheTag = 0x0000000000000300ULL;
 constexpr auto kWebDocumentCacheTag = 0x0000020000000000ULL;
 constexpr auto kUrlCacheTag = 0x0000030000000000ULL;
 constexpr auto kGeoPointCacheTag = 0x0000040000000000ULL;
+constexpr auto kHistorySliceCacheTag = 0x0000050000000000ULL;
+constexpr auto kSharedMediaCacheTag = 0x0000060000000000ULL;
+constexpr auto kSharedMediaCacheMask = 0x00000000000000FFULL;
 
 } // namespace
 
@@ -95,6 +98,21 @@ Storage::Cache::Key AudioAlbumThumbCacheKey(
 	};
 }
 
+Storage::Cache::Key HistorySliceCacheKey(PeerId peerId) {
+	return Storage::Cache::Key{
+		Data::kHistorySliceCacheTag,
+		SerializePeerId(peerId),
+	};
+}
+
+Storage::Cache::Key SharedMediaCacheKey(PeerId peerId, int type) {
+	const auto part = (uint64(type) & Data::kSharedMediaCacheMask);
+	return Storage::Cache::Key{
+		Data::kSharedMediaCacheTag | part,
+		SerializePeerId(peerId),
+	};
+}
+
 } // namespace Data
 
 void MessageCursor::fillFrom(not_null<const Ui::InputField*> field) {
@@ -12,6 +12,17 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history.h"
 
 namespace Dialogs {
+namespace {
+
+constexpr auto kTrigramLength = 3;
+
+[[nodiscard]] uint64 Trigram(const QChar *from) {
+	return (uint64(from[0].unicode()) << 32)
+		| (uint64(from[1].unicode()) << 16)
+		| uint64(from[2].unicode());
+}
+
+} // namespace
 
 IndexedList::IndexedList(SortMode sortMode, FilterId filterId)
 : _sortMode(sortMode)
@@ -33,6 +44,7 @@ RowsByLetter IndexedList::addToEnd(Key key) {
 		}
 		result.letters.emplace(ch, j->second.addToEnd(key));
 	}
+	addTrigrams(key);
 	return result;
 }
 
@@ -49,6 +61,7 @@ Row *IndexedList::addByName(Key key) {
 		}
 		j->second.addByName(key);
 	}
+	addTrigrams(key);
 	return result;
 }
 
@@ -127,6 +140,9 @@ void IndexedList::adjustByName(
 	const auto mainRow = _list.adjustByName(key);
 	if (!mainRow) return;
 
+	removeTrigrams(key);
+	addTrigrams(key);
+
 	auto toRemove = oldLetters;
 	auto toAdd = base::flat_set<QChar>();
 	for (const auto &ch : key.entry()->chatListFirstLetters()) {
@@ -164,6 +180,9 @@ void IndexedList::adjustNames(
 	auto mainRow = _list.getRow(key);
 	if (!mainRow) return;
 
+	removeTrigrams(key);
+	addTrigrams(key);
+
 	auto toRemove = oldLetters;
 	auto toAdd = base::flat_set<QChar>();
 	for (const auto &ch : key.entry()->chatListFirstLetters()) {
@@ -196,6 +215,7 @@ void IndexedList::adjustNames(
 
 void IndexedList::remove(Key key, Row *replacedBy) {
 	if (_list.remove(key, replacedBy)) {
+		removeTrigrams(key);
 		for (const auto &ch : key.entry()->chatListFirstLetters()) {
 			if (const auto it = _index.find(ch); it != _index.cend()) {
 				it->second.remove(key, replacedBy);
@@ -207,54 +227,166 @@ void IndexedList::remove(Key key, Row *replacedBy) {
 void IndexedList::clear() {
 	_list.clear();
 	_index.clear();
+	_byTrigram.clear();
+	_trigrams.clear();
+	_trigramsBuilt = false;
 }
 
-std::vector<not_null<Row*>> IndexedList::filtered(
-		const QStringList &words) const {
-	const auto minimal = [&]() -> const Dialogs::List* {
-		if (empty()) {
-			return nullptr;
+void IndexedList::ensureTrigrams() {
+	if (_trigramsBuilt) {
+		return;
+	}
+	_trigramsBuilt = true;
+	for (const auto &row : _list) {
+		addTrigrams(row->key());
+	}
+}
+
+void IndexedList::addTrigrams(Key key) {
+	if (!_trigramsBuilt) {
+		return;
+	}
+	auto trigrams = std::vector<uint64>();
+	for (const auto &word : key.entry()->chatListNameWords()) {
+		const auto data = word.constData();
+		for (auto i = 0; i + kTrigramLength <= word.size(); ++i) {
+			trigrams.push_back(Trigram(data + i));
 		}
-		auto result = (const Dialogs::List*)nullptr;
-		for (const auto &word : words) {
-			if (word.isEmpty()) {
-				continue;
-			}
+	}
+	if (trigrams.empty()) {
+		return;
+	}
+	ranges::sort(trigrams);
+	trigrams.erase(ranges::unique(trigrams), end(trigrams));
+	for (const auto trigram : trigrams) {
+		_byTrigram[trigram].emplace(key);
+	}
+	_trigrams[key] = std::move(trigrams);
+}
+
+void IndexedList::removeTrigrams(Key key) {
+	const auto i = _trigrams.find(key);
+	if (i == end(_trigrams)) {
+		return;
+	}
+	for (const auto trigram : i->second) {
+		const auto j = _byTrigram.find(trigram);
+		if (j == end(_byTrigram)) {
+			continue;
+		}
+		auto &keys = j->second;
+		keys.remove(key);
+		if (keys.empty()) {
+			_byTrigram.erase(j);
+		}
+	}
+	_trigrams.erase(i);
+}
+
+const base::flat_set<Key> *IndexedList::withTrigram(
+		uint64 trigram) const {
+	const auto i = _byTrigram.find(trigram);
+	return (i != end(_byTrigram)) ? &i->second : nullptr;
+}
+
+std::vector<not_null<Row*>> IndexedList::filtered(
+		const QStringList &words) {
+	auto result = std::vector<not_null<Row*>>();
+	if (empty()) {
+		return result;
+	}
+	ensureTrigrams();
+
+	// Take the smallest list of candidates: the first letter list for
+	// a short word or the rarest trigram of a long one.
+	auto byLetter = (const Dialogs::List*)nullptr;
+	auto byTrigram = (const base::flat_set<Key>*)nullptr;
+	auto minimal = std::numeric_limits<int>::max();
+	for (const auto &word : words) {
+		if (word.isEmpty()) {
+			continue;
+		} else if (word.size() < kTrigramLength) {
 			const auto found = filtered(word[0]);
 			if (!found || found->empty()) {
-				return nullptr;
-			} else if (!result || result->size() > found->size()) {
-				result = found;
+				return result;
+			} else if (found->size() < minimal) {
+				minimal = found->size();
+				byLetter = found;
+				byTrigram = nullptr;
 			}
+			continue;
 		}
-		return result;
-	}();
-	auto result = std::vector<not_null<Row*>>();
-	if (!minimal || minimal->empty()) {
+		const auto data = word.constData();
+		for (auto i = 0; i + kTrigramLength <= word.size(); ++i) {
+			const auto found = withTrigram(Trigram(data + i));
+			if (!found) {
+				return result;
+			} else if (int(found->size()) < minimal) {
+				minimal = found->size();
+				byLetter = nullptr;
+				byTrigram = found;
+			}
+		}
+	}
+	if (!byLetter && !byTrigram) {
 		return result;
 	}
-	result.reserve(minimal->size());
-	for (const auto &row : *minimal) {
+
+	auto prefixMatches = 0;
+	const auto check = [&](not_null<Row*> row) {
 		const auto &nameWords = row->entry()->chatListNameWords();
-		const auto found = [&](const QString &word) {
+		auto allPrefixes = true;
+		for (const auto &word : words) {
+			auto found = false;
+			auto prefix = false;
 			for (const auto &name : nameWords) {
 				if (name.startsWith(word)) {
-					return true;
+					found = prefix = true;
+					break;
+				} else if (!found
+					&& word.size() >= kTrigramLength
+					&& name.contains(word)) {
+					found = true;
 				}
 			}
-			return false;
-		};
-		const auto allFound = [&] {
-			for (const auto &word : words) {
-				if (!found(word)) {
-					return false;
-				}
+			if (!found) {
+				return;
 			}
-			return true;
-		}();
-		if (allFound) {
-			result.push_back(row);
+			allPrefixes = allPrefixes && prefix;
+		}
+		if (allPrefixes) {
+			++prefixMatches;
+		}
+		result.push_back(row);
+	};
+	if (byLetter) {
+		result.reserve(byLetter->size());
+		for (const auto &row : *byLetter) {
+			check(row);
 		}
+	} else {
+		auto rows = std::vector<not_null<Row*>>();
+		rows.reserve(byTrigram->size());
+		for (const auto &key : *byTrigram) {
+			if (const auto row = _list.getRow(key)) {
+				rows.push_back(row);
+			}
+		}
+		ranges::sort(rows, ranges::less(), &Row::index);
+		result.reserve(rows.size());
+		for (const auto &row : rows) {
+			check(row);
+		}
+	}
+	if (prefixMatches > 0 && prefixMatches < int(result.size())) {
+		ranges::stable_partition(result, [&](not_null<Row*> row) {
+			const auto &nameWords = row->entry()->chatListNameWords();
+			return ranges::all_of(words, [&](const QString &word) {
+				return ranges::any_of(nameWords, [&](const QString &name) {
+					return name.startsWith(word);
+				});
+			});
+		});
 	}
 	return result;
 }
@@ -49,8 +49,12 @@ public:
 		const auto i = _index.find(ch);
 		return (i != _index.end()) ? &i->second : nullptr;
 	}
+	// Query words shorter than three letters match the beginning of
+	// a name word, longer ones match anywhere inside of it. Rows where
+	// all words match the beginnings go first.
+	// The first call builds the trigram index, it is kept up to date after.
 	[[nodiscard]] std::vector<not_null<Row*>> filtered(
-		const QStringList &words) const;
+		const QStringList &words);
 
 	// Part of List interface is duplicated here for all() list.
 	[[nodiscard]] int size() const { return all().size(); }
@@ -91,11 +95,23 @@ private:
 		not_null<History*> history,
 		const base::flat_set<QChar> &oldChars);
 
+	void ensureTrigrams();
+	void addTrigrams(Key key);
+	void removeTrigrams(Key key);
+	[[nodiscard]] const base::flat_set<Key> *withTrigram(
+		uint64 trigram) const;
+
 	SortMode _sortMode = SortMode();
 	FilterId _filterId = 0;
 	List _list, _empty;
 	base::flat_map<QChar, List> _index;
 
+	// Inverted index from trigrams of name words to keys having them.
+	// Only lists that are searched by substring have it.
+	std::unordered_map<uint64, base::flat_set<Key>> _byTrigram;
+	std::map<Key, std::vector<uint64>> _trigrams;
+	bool _trigramsBuilt = false;
+
 };
 
 } // namespace Dialogs
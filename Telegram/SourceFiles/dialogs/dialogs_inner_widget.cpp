@@ -309,31 +309,44 @@ InnerWidget::InnerWidget(
 		}
 	}, lifetime());
 
+	// Catching up after sleep brings thousands of updates in one go,
+	// so they are handled once per batch instead of once per update.
 	using UpdateFlag = Data::PeerUpdate::Flag;
-	session().changes().peerUpdates(
+	session().changes().peerUpdatesBatched(
 		UpdateFlag::Name
 		| UpdateFlag::Photo
 		| UpdateFlag::IsContact
 		| UpdateFlag::FullInfo
 		| UpdateFlag::EmojiStatus
-	) | rpl::start_with_next([=](const Data::PeerUpdate &update) {
-		if (update.flags
-			& (UpdateFlag::Name
-				| UpdateFlag::Photo
-				| UpdateFlag::FullInfo
-				| UpdateFlag::EmojiStatus)) {
-			const auto peer = update.peer;
-			const auto history = peer->owner().historyLoaded(peer);
-			if (_state == WidgetState::Default) {
-				if (history) {
-					updateDialogRow({ history, FullMsgId() });
+	) | rpl::start_with_next([=](
+			const std::vector<Data::PeerUpdate> &updates) {
+		auto updated = false;
+		auto contacts = false;
+		for (const auto &update : updates) {
+			if (update.flags
+				& (UpdateFlag::Name
+					| UpdateFlag::Photo
+					| UpdateFlag::FullInfo
+					| UpdateFlag::EmojiStatus)) {
+				const auto peer = update.peer;
+				const auto history = peer->owner().historyLoaded(peer);
+				if (_state == WidgetState::Default) {
+					if (history) {
+						updateDialogRow({ history, FullMsgId() });
+					}
+				} else {
+					this->update();
 				}
-			} else {
-				this->update();
+				updated = true;
+			}
+			if (update.flags & UpdateFlag::IsContact) {
+				contacts = true;
 			}
+		}
+		if (updated) {
 			_updated.fire({});
 		}
-		if (update.flags & UpdateFlag::IsContact) {
+		if (contacts) {
 			// contactsNoChatsList could've changed.
 			Ui::PostponeCall(this, [=] { refresh(); });
 		}
@@ -345,26 +358,33 @@ InnerWidget::InnerWidget(
 		refreshDialogRow({ update.item->history(), update.item->fullId() });
 	}, lifetime());
 
-	session().changes().entryUpdates(
+	session().changes().entryUpdatesBatched(
 		Data::EntryUpdate::Flag::Repaint
 		| Data::EntryUpdate::Flag::Height
-	) | rpl::start_with_next([=](const Data::EntryUpdate &update) {
-		const auto entry = update.entry;
-		if (update.flags & Data::EntryUpdate::Flag::Height) {
-			if (updateEntryHeight(entry)) {
-				refresh();
+	) | rpl::start_with_next([=](
+			const std::vector<Data::EntryUpdate> &updates) {
+		auto heightChanged = false;
+		for (const auto &update : updates) {
+			const auto entry = update.entry;
+			if (update.flags & Data::EntryUpdate::Flag::Height) {
+				if (updateEntryHeight(entry)) {
+					heightChanged = true;
+				}
+				continue;
+			}
+			const auto repaintId = (_state == WidgetState::Default)
+				? _filterId
+				: 0;
+			if (const auto links = entry->chatListLinks(repaintId)) {
+				repaintDialogRow(repaintId, links->main);
+			}
+			if (session().supportMode()
+				&& !session().settings().supportAllSearchResults()) {
+				repaintDialogRow({ entry, FullMsgId() });
 			}
-			return;
-		}
-		const auto repaintId = (_state == WidgetState::Default)
-			? _filterId
-			: 0;
-		if (const auto links = entry->chatListLinks(repaintId)) {
-			repaintDialogRow(repaintId, links->main);
 		}
-		if (session().supportMode()
-			&& !session().settings().supportAllSearchResults()) {
-			repaintDialogRow({ entry, FullMsgId() });
+		if (heightChanged) {
+			refresh();
 		}
 	}, lifetime());
 
@@ -705,6 +725,11 @@ void InnerWidget::paintEvent(QPaintEvent *e) {
 			&& _selectedTopicJump
 			&& (!_pressed || _pressedTopicJump);
 		Ui::RowPainter::Paint(p, row, validateVideoUserpic(row), context);
+		if (const auto history = key.history()) {
+			if (history->lastItemDialogsView().hasHeavyPart()) {
+				_heavyPreviews.emplace(history);
+			}
+		}
 	};
 	if (_state == WidgetState::Default) {
 		const auto collapsedSkip = collapsedRowsOffset();
@@ -2757,7 +2782,7 @@ void InnerWidget::appendToFiltered(Key key) {
 			return;
 		}
 	}
-	auto row = std::make_unique<Row>(key, 0, 0);
+	auto row = std::make_unique<Row>(key);
 	row->recountHeight(_narrowRatio);
 	const auto &[i, ok] = _filterResultsGlobal.emplace(key, std::move(row));
 	const auto height = filteredHeight();
@@ -2949,6 +2974,7 @@ void InnerWidget::visibleTopBottomUpdated(
 	_visibleTop = visibleTop;
 	_visibleBottom = visibleBottom;
 	preloadRowsData();
+	unloadHeavyPreviews();
 	const auto loadTill = _visibleTop
 		+ PreloadHeightsCount * (_visibleBottom - _visibleTop);
 	if (_state == WidgetState::Filtered && loadTill >= peerSearchOffset()) {
@@ -2963,6 +2989,28 @@ void InnerWidget::visibleTopBottomUpdated(
 	}
 }
 
+void InnerWidget::unloadHeavyPreviews() {
+	if (_heavyPreviews.empty() || _state != WidgetState::Default) {
+		return;
+	}
+	const auto height = _visibleBottom - _visibleTop;
+	const auto keepFrom = _visibleTop - height;
+	const auto keepTill = _visibleBottom + height;
+	const auto skip = dialogsOffset() - skipTopHeight();
+	for (auto i = _heavyPreviews.begin(); i != _heavyPreviews.end();) {
+		const auto history = *i;
+		if (const auto row = _shownList->getRow({ history })) {
+			const auto top = skip + row->top();
+			if (top + row->height() > keepFrom && top < keepTill) {
+				++i;
+				continue;
+			}
+		}
+		history->lastItemDialogsView().unloadHeavyPart();
+		i = _heavyPreviews.erase(i);
+	}
+}
+
 void InnerWidget::itemRemoved(not_null<const HistoryItem*> item) {
 	int wasCount = _searchResults.size();
 	for (auto i = _searchResults.begin(); i != _searchResults.end();) {
@@ -275,6 +275,7 @@ private:
 	void clearIrrelevantState();
 	void selectByMouse(QPoint globalPosition);
 	void preloadRowsData();
+	void unloadHeavyPreviews();
 	void scrollToItem(int top, int height);
 	void scrollToDefaultSelected();
 	void setCollapsedPressed(int pressed);
@@ -472,6 +473,7 @@ private:
 
 	int _visibleTop = 0;
 	int _visibleBottom = 0;
+	base::flat_set<not_null<History*>> _heavyPreviews;
 	QString _filter, _hashtagFilter;
 
 	std::vector<std::unique_ptr<HashtagResult>> _hashtagResults;
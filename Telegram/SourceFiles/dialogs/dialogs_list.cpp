@@ -12,12 +12,213 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_session.h"
 
 namespace Dialogs {
+namespace {
+
+[[nodiscard]] uint32 NextPriority(uint64 &state) {
+	auto result = (state += 0x9E3779B97F4A7C15ULL);
+	result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	result = (result ^ (result >> 27)) * 0x94D049BB133111EBULL;
+	return uint32(result ^ (result >> 31));
+}
+
+} // namespace
 
 List::List(SortMode sortMode, FilterId filterId)
 : _sortMode(sortMode)
 , _filterId(filterId) {
 }
 
+List::List(List &&other)
+: _sortMode(other._sortMode)
+, _filterId(other._filterId)
+, _narrowRatio(other._narrowRatio)
+, _root(base::take(other._root))
+, _priorities(other._priorities)
+, _rows(base::take(other._rows))
+, _rowsValid(std::exchange(other._rowsValid, true))
+, _rowByKey(base::take(other._rowByKey)) {
+}
+
+List &List::operator=(List &&other) {
+	_sortMode = other._sortMode;
+	_filterId = other._filterId;
+	_narrowRatio = other._narrowRatio;
+	_root = base::take(other._root);
+	_priorities = other._priorities;
+	_rows = base::take(other._rows);
+	_rowsValid = std::exchange(other._rowsValid, true);
+	_rowByKey = base::take(other._rowByKey);
+	return *this;
+}
+
+List::~List() = default;
+
+void List::clear() {
+	_root = nullptr;
+	_rows.clear();
+	_rowsValid = true;
+	_rowByKey.clear();
+}
+
+void List::Update(not_null<Row*> node) {
+	node->_count = 1;
+	node->_subtreeHeight = node->_height;
+	if (const auto left = node->_left) {
+		left->_parent = node;
+		node->_count += left->_count;
+		node->_subtreeHeight += left->_subtreeHeight;
+	}
+	if (const auto right = node->_right) {
+		right->_parent = node;
+		node->_count += right->_count;
+		node->_subtreeHeight += right->_subtreeHeight;
+	}
+}
+
+void List::UpdateAll(Row *node) {
+	if (node) {
+		UpdateAll(node->_left);
+		UpdateAll(node->_right);
+		Update(node);
+	}
+}
+
+Row *List::Merge(Row *a, Row *b) {
+	if (!a || !b) {
+		return a ? a : b;
+	} else if (a->_priority > b->_priority) {
+		a->_right = Merge(a->_right, b);
+		Update(a);
+		return a;
+	}
+	b->_left = Merge(a, b->_left);
+	Update(b);
+	return b;
+}
+
+std::pair<Row*, Row*> List::Split(Row *node, int count) {
+	if (!node) {
+		return {};
+	}
+	const auto left = node->_left ? node->_left->_count : 0;
+	if (count <= left) {
+		const auto [first, second] = Split(node->_left, count);
+		node->_left = second;
+		Update(node);
+		if (first) {
+			first->_parent = nullptr;
+		}
+		return { first, node };
+	}
+	const auto [first, second] = Split(node->_right, count - left - 1);
+	node->_right = first;
+	Update(node);
+	if (second) {
+		second->_parent = nullptr;
+	}
+	return { node, second };
+}
+
+void List::insertAt(not_null<Row*> row, int position) {
+	row->_parent = row->_left = row->_right = nullptr;
+	Update(row);
+	const auto [first, second] = Split(_root, position);
+	_root = Merge(Merge(first, row), second);
+	_root->_parent = nullptr;
+}
+
+void List::detach(not_null<Row*> row) {
+	const auto [first, rest] = Split(_root, row->index());
+	const auto [middle, second] = Split(rest, 1);
+	Assert(middle == row);
+
+	_root = Merge(first, second);
+	if (_root) {
+		_root->_parent = nullptr;
+	}
+	row->_parent = row->_left = row->_right = nullptr;
+	Update(row);
+}
+
+void List::moveTo(not_null<Row*> row, int index, int position) {
+	insertAt(row, position);
+	if (position != index) {
+		_rowsValid = false;
+	}
+}
+
+not_null<Row*> List::rowAt(int position) const {
+	Expects(position >= 0 && position < size());
+
+	auto node = _root;
+	while (true) {
+		const auto left = node->_left ? node->_left->_count : 0;
+		if (position < left) {
+			node = node->_left;
+		} else if (position == left) {
+			return node;
+		} else {
+			position -= left + 1;
+			node = node->_right;
+		}
+	}
+}
+
+int List::positionByY(int y) const {
+	// Count of rows with the bottom not below y.
+	auto result = 0;
+	auto top = 0;
+	for (auto node = _root; node;) {
+		const auto left = node->_left;
+		const auto bottom = top
+			+ (left ? left->_subtreeHeight : 0)
+			+ node->_height;
+		if (bottom < y) {
+			result += (left ? left->_count : 0) + 1;
+			top = bottom;
+			node = node->_right;
+		} else {
+			node = left;
+		}
+	}
+	return result;
+}
+
+template <typename Predicate>
+int List::countLeading(Predicate &&predicate) const {
+	auto result = 0;
+	for (auto node = _root; node;) {
+		if (predicate(not_null<Row*>(node))) {
+			result += (node->_left ? node->_left->_count : 0) + 1;
+			node = node->_right;
+		} else {
+			node = node->_left;
+		}
+	}
+	return result;
+}
+
+const std::vector<not_null<Row*>> &List::rows() const {
+	if (!_rowsValid) {
+		_rowsValid = true;
+		_rows.clear();
+		_rows.reserve(size());
+		auto stack = std::vector<Row*>();
+		for (auto node = _root; node || !stack.empty();) {
+			if (node) {
+				stack.push_back(node);
+				node = node->_left;
+			} else {
+				node = stack.back();
+				stack.pop_back();
+				_rows.push_back(node);
+				node = node->_right;
+			}
+		}
+	}
+	return _rows;
+}
+
 List::const_iterator List::cfind(Row *value) const {
 	return value
 		? (cbegin() + value->index())
@@ -30,10 +231,12 @@ not_null<Row*> List::addToEnd(Key key) {
 	}
 	const auto result = _rowByKey.emplace(
 		key,
-		std::make_unique<Row>(key, _rows.size(), height())
+		std::make_unique<Row>(key)
 	).first->second.get();
+	result->_priority = NextPriority(_priorities);
 	result->recountHeight(_narrowRatio);
-	_rows.emplace_back(result);
+	insertAt(result, _root ? _root->_count : 0);
+	_rowsValid = false;
 	if (_sortMode == SortMode::Date) {
 		adjustByDate(result);
 	}
@@ -60,25 +263,18 @@ not_null<Row*> List::addByName(Key key) {
 }
 
 void List::adjustByName(not_null<Row*> row) {
-	Expects(row->index() >= 0 && row->index() < _rows.size());
-
 	const auto &key = row->entry()->chatListNameSortKey();
 	const auto index = row->index();
-	const auto i = _rows.begin() + index;
-	const auto before = std::find_if(i + 1, _rows.end(), [&](Row *row) {
-		return row->entry()->chatListNameSortKey().compare(key) >= 0;
+	detach(row);
+
+	// Stay in place if there are equal keys around, like a linear scan.
+	const auto lower = countLeading([&](not_null<Row*> other) {
+		return other->entry()->chatListNameSortKey().compare(key) < 0;
 	});
-	if (before != i + 1) {
-		rotate(i, i + 1, before);
-	} else if (i != _rows.begin()) {
-		const auto from = std::make_reverse_iterator(i);
-		const auto after = std::find_if(from, _rows.rend(), [&](Row *row) {
-			return row->entry()->chatListNameSortKey().compare(key) <= 0;
-		}).base();
-		if (after != i) {
-			rotate(after, i, i + 1);
-		}
-	}
+	const auto upper = countLeading([&](not_null<Row*> other) {
+		return other->entry()->chatListNameSortKey().compare(key) <= 0;
+	});
+	moveTo(row, index, std::clamp(index, lower, upper));
 }
 
 void List::adjustByDate(not_null<Row*> row) {
@@ -86,21 +282,15 @@ void List::adjustByDate(not_null<Row*> row) {
 
 	const auto key = row->sortKey(_filterId);
 	const auto index = row->index();
-	const auto i = _rows.begin() + index;
-	const auto before = std::find_if(i + 1, _rows.end(), [&](Row *row) {
-		return (row->sortKey(_filterId) <= key);
+	detach(row);
+
+	const auto lower = countLeading([&](not_null<Row*> other) {
+		return (other->sortKey(_filterId) > key);
 	});
-	if (before != i + 1) {
-		rotate(i, i + 1, before);
-	} else {
-		const auto from = std::make_reverse_iterator(i);
-		const auto after = std::find_if(from, _rows.rend(), [&](Row *row) {
-			return (row->sortKey(_filterId) >= key);
-		}).base();
-		if (after != i) {
-			rotate(after, i, i + 1);
-		}
-	}
+	const auto upper = countLeading([&](not_null<Row*> other) {
+		return (other->sortKey(_filterId) >= key);
+	});
+	moveTo(row, index, std::clamp(index, lower, upper));
 }
 
 bool List::updateHeight(Key key, float64 narrowRatio) {
@@ -109,29 +299,24 @@ bool List::updateHeight(Key key, float64 narrowRatio) {
 		return false;
 	}
 	const auto row = i->second.get();
-	const auto index = row->index();
-	auto top = row->top();
 	const auto was = row->height();
 	row->recountHeight(narrowRatio);
 	if (row->height() == was) {
 		return false;
 	}
-	for (auto i = _rows.begin() + index, e = _rows.end(); i != e; ++i) {
-		(*i)->_top = top;
-		top += (*i)->height();
+	for (auto node = row; node; node = node->_parent) {
+		Update(node);
 	}
 	return true;
 }
 
 bool List::updateHeights(float64 narrowRatio) {
 	_narrowRatio = narrowRatio;
-	auto was = height();
-	auto top = 0;
-	for (const auto &row : _rows) {
-		row->_top = top;
+	const auto was = height();
+	for (const auto &[key, row] : _rowByKey) {
 		row->recountHeight(narrowRatio);
-		top += row->height();
 	}
+	UpdateAll(_root);
 	return (height() != was);
 }
 
@@ -140,27 +325,13 @@ bool List::moveToTop(Key key) {
 	if (i == _rowByKey.cend()) {
 		return false;
 	}
-	const auto index = i->second->index();
-	const auto begin = _rows.begin();
-	rotate(begin, begin + index, begin + index + 1);
-	return true;
-}
-
-void List::rotate(
-		std::vector<not_null<Row*>>::iterator first,
-		std::vector<not_null<Row*>>::iterator middle,
-		std::vector<not_null<Row*>>::iterator last) {
-	auto top = (*first)->top();
-	std::rotate(first, middle, last);
-
-	auto count = (last - first);
-	auto index = (first - _rows.begin());
-	while (count--) {
-		const auto row = *first++;
-		row->_index = index++;
-		row->_top = top;
-		top += row->height();
+	const auto row = i->second.get();
+	const auto index = row->index();
+	if (index > 0) {
+		detach(row);
+		moveTo(row, index, 0);
 	}
+	return true;
 }
 
 bool List::remove(Key key, Row *replacedBy) {
@@ -172,34 +343,25 @@ bool List::remove(Key key, Row *replacedBy) {
 	const auto row = i->second.get();
 	row->entry()->owner().dialogsRowReplaced({ row, replacedBy });
 
-	auto top = row->top();
-	const auto index = row->index();
-	_rows.erase(_rows.begin() + index);
-	for (auto i = index, count = int(_rows.size()); i != count; ++i) {
-		const auto row = _rows[i];
-		row->_index = i;
-		row->_top = top;
-		top += row->height();
-	}
+	detach(row);
+	_rowsValid = false;
 	_rowByKey.erase(i);
 	return true;
 }
 
 Row *List::rowAtY(int y) const {
-	const auto i = findByY(y);
-	if (i == cend()) {
+	const auto position = positionByY(y);
+	if (position == size()) {
 		return nullptr;
 	}
-	const auto row = *i;
+	const auto row = rowAt(position);
 	const auto top = row->top();
 	const auto bottom = top + row->height();
 	return (top <= y && bottom > y) ? row.get() : nullptr;
 }
 
 List::iterator List::findByY(int y) const {
-	return ranges::lower_bound(_rows, y, ranges::less(), [](const Row *row) {
-		return row->top() + row->height();
-	});
+	return cbegin() + positionByY(y);
 }
 
 } // namespace Dialogs
@@ -14,29 +14,28 @@ namespace Dialogs {
 
 enum class SortMode;
 
+// Rows are kept in an order statistic tree (a treap with parent links)
+// that also sums row heights, so moving, removing or resizing a row and
+// finding a row by its top are O(log n). The plain vector used for
+// iteration is rebuilt only when the list is iterated after a change.
 class List final {
 public:
 	List(SortMode sortMode, FilterId filterId = 0);
 	List(const List &other) = delete;
 	List &operator=(const List &other) = delete;
-	List(List &&other) = default;
-	List &operator=(List &&other) = default;
-	~List() = default;
+	List(List &&other);
+	List &operator=(List &&other);
+	~List();
 
-	void clear() {
-		_rows.clear();
-		_rowByKey.clear();
-	}
+	void clear();
 	[[nodiscard]] int size() const {
-		return _rows.size();
+		return _rowByKey.size();
 	}
 	[[nodiscard]] bool empty() const {
-		return _rows.empty();
+		return _rowByKey.empty();
 	}
 	[[nodiscard]] int height() const {
-		return _rows.empty()
-			? 0
-			: (_rows.back()->top() + _rows.back()->height());
+		return _root ? _root->_subtreeHeight : 0;
 	}
 	[[nodiscard]] bool contains(Key key) const {
 		return _rowByKey.find(key) != _rowByKey.end();
@@ -59,8 +58,8 @@ public:
 	using const_iterator = std::vector<not_null<Row*>>::const_iterator;
 	using iterator = const_iterator;
 
-	[[nodiscard]] const_iterator cbegin() const { return _rows.cbegin(); }
-	[[nodiscard]] const_iterator cend() const { return _rows.cend(); }
+	[[nodiscard]] const_iterator cbegin() const { return rows().cbegin(); }
+	[[nodiscard]] const_iterator cend() const { return rows().cend(); }
 	[[nodiscard]] const_iterator begin() const { return cbegin(); }
 	[[nodiscard]] const_iterator end() const { return cend(); }
 	[[nodiscard]] iterator begin() { return cbegin(); }
@@ -73,16 +72,28 @@ public:
 	[[nodiscard]] iterator findByY(int y) const;
 
 private:
+	static void Update(not_null<Row*> node);
+	static void UpdateAll(Row *node);
+	[[nodiscard]] static Row *Merge(Row *a, Row *b);
+	[[nodiscard]] static std::pair<Row*, Row*> Split(Row *node, int count);
+
 	void adjustByName(not_null<Row*> row);
-	void rotate(
-		std::vector<not_null<Row*>>::iterator first,
-		std::vector<not_null<Row*>>::iterator middle,
-		std::vector<not_null<Row*>>::iterator last);
+	void insertAt(not_null<Row*> row, int position);
+	void detach(not_null<Row*> row);
+	void moveTo(not_null<Row*> row, int index, int position);
+	[[nodiscard]] not_null<Row*> rowAt(int position) const;
+	[[nodiscard]] int positionByY(int y) const;
+	template <typename Predicate>
+	[[nodiscard]] int countLeading(Predicate &&predicate) const;
+	[[nodiscard]] const std::vector<not_null<Row*>> &rows() const;
 
 	SortMode _sortMode = SortMode();
 	FilterId _filterId = 0;
 	float64 _narrowRatio = 0.;
-	std::vector<not_null<Row*>> _rows;
+	Row *_root = nullptr;
+	uint64 _priorities = 0;
+	mutable std::vector<not_null<Row*>> _rows;
+	mutable bool _rowsValid = true;
 	std::map<Key, std::unique_ptr<Row>> _rowByKey;
 
 };
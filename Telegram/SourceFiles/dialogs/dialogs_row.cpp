@@ -312,12 +312,35 @@ void BasicRow::paintUserpic(
 	PaintUserpic(p, entry, peer, videoUserpic, _userpic, context);
 }
 
-Row::Row(Key key, int index, int top) : _id(key), _top(top), _index(index) {
+Row::Row(Key key) : _id(key) {
 	if (const auto history = key.history()) {
 		updateCornerBadgeShown(history->peer);
 	}
 }
 
+int Row::index() const {
+	auto result = _left ? _left->_count : 0;
+	for (auto node = this; node->_parent; node = node->_parent) {
+		const auto parent = node->_parent;
+		if (parent->_right == node) {
+			result += (parent->_left ? parent->_left->_count : 0) + 1;
+		}
+	}
+	return result;
+}
+
+int Row::top() const {
+	auto result = _left ? _left->_subtreeHeight : 0;
+	for (auto node = this; node->_parent; node = node->_parent) {
+		const auto parent = node->_parent;
+		if (parent->_right == node) {
+			result += (parent->_left ? parent->_left->_subtreeHeight : 0)
+				+ parent->_height;
+		}
+	}
+	return result;
+}
+
 Row::~Row() {
 	clearTopicJumpRipple();
 }
@@ -83,12 +83,10 @@ class Row final : public BasicRow {
 public:
 	explicit Row(std::nullptr_t) {
 	}
-	Row(Key key, int index, int top);
+	explicit Row(Key key);
 	~Row();
 
-	[[nodiscard]] int top() const {
-		return _top;
-	}
+	[[nodiscard]] int top() const;
 	[[nodiscard]] int height() const {
 		Expects(_height != 0);
 
@@ -137,9 +135,7 @@ public:
 	[[nodiscard]] not_null<Entry*> entry() const {
 		return _id.entry();
 	}
-	[[nodiscard]] int index() const {
-		return _index;
-	}
+	[[nodiscard]] int index() const;
 	[[nodiscard]] uint64 sortKey(FilterId filterId) const;
 
 	// for any attached data, for example View in contacts list
@@ -197,9 +193,16 @@ private:
 
 	Key _id;
 	mutable std::unique_ptr<CornerBadgeUserpic> _cornerBadgeUserpic;
-	int _top = 0;
 	int _height = 0;
-	uint32 _index : 30 = 0;
+
+	// Node of the List order statistic tree, see dialogs_list.cpp.
+	Row *_parent = nullptr;
+	Row *_left = nullptr;
+	Row *_right = nullptr;
+	uint32 _priority = 0;
+	int _count = 1;
+	int _subtreeHeight = 0;
+
 	uint32 _cornerBadgeShown : 1 = 0;
 	uint32 _topicJumpRipple : 1 = 0;
 
@@ -50,6 +50,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/ui_integration.h"
 #include "core/update_checker.h"
 #include "core/shortcuts.h"
+#include "core/tracing.h"
 #include "boxes/peer_list_box.h"
 #include "boxes/peers/edit_participants_box.h"
 #include "window/window_adaptive.h"
@@ -3556,6 +3557,12 @@ void Widget::paintEvent(QPaintEvent *e) {
 	if (controller()->contentOverlapped(this, e)) {
 		return;
 	}
+	if (Tracing::Enabled()) {
+		static auto first = true;
+		if (base::take(first)) {
+			Tracing::Instant("Dialogs::Widget first paint");
+		}
+	}
 
 	Painter p(this);
 	QRect r(e->rect());
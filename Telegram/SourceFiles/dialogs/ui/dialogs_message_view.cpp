@@ -27,6 +27,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace {
 
 constexpr auto kEmojiLoopCount = 12;
+constexpr auto kSharedTextsLimit = 1024;
 
 template <ushort kTag>
 struct TextWithTagOffset {
@@ -82,6 +83,91 @@ TextWithTagOffset<kTag> ReplaceTag<TextWithTagOffset<kTag>>::Call(
 } // namespace Lang
 
 namespace Dialogs::Ui {
+namespace {
+
+// Previews without custom emoji don't depend on the row they are shown
+// in, so all the rows showing the same text share one parsed String.
+class SharedTexts final {
+public:
+	[[nodiscard]] std::shared_ptr<const Text::String> lookup(
+		TextWithEntities &&text);
+
+private:
+	struct Entry {
+		EntitiesInText entities;
+		std::shared_ptr<const Text::String> string;
+		uint64 lastUsed = 0;
+	};
+
+	void evict();
+
+	base::flat_map<QString, std::vector<Entry>> _entries;
+	int _count = 0;
+	uint64 _lastUsed = 0;
+	int64 _hits = 0;
+	int64 _misses = 0;
+
+};
+
+std::shared_ptr<const Text::String> SharedTexts::lookup(
+		TextWithEntities &&text) {
+	auto &list = _entries[text.text];
+	const auto i = ranges::find(list, text.entities, &Entry::entities);
+	if (i != end(list)) {
+		++_hits;
+		i->lastUsed = ++_lastUsed;
+		return i->string;
+	}
+	++_misses;
+	auto string = std::make_shared<Text::String>(st::dialogsTextWidthMin);
+	string->setMarkedText(st::dialogsTextStyle, text, DialogTextOptions());
+	list.push_back({
+		.entities = std::move(text.entities),
+		.string = string,
+		.lastUsed = ++_lastUsed,
+	});
+	if (++_count > kSharedTextsLimit) {
+		evict();
+	}
+	return string;
+}
+
+void SharedTexts::evict() {
+	auto used = std::vector<uint64>();
+	used.reserve(_count);
+	for (const auto &[text, list] : _entries) {
+		for (const auto &entry : list) {
+			used.push_back(entry.lastUsed);
+		}
+	}
+
+	// Drop the least recently used quarter, rows keep their copies.
+	const auto border = used.begin() + (_count / 4);
+	ranges::nth_element(used, border);
+	const auto till = *border;
+	for (auto i = begin(_entries); i != end(_entries);) {
+		auto &list = i->second;
+		list.erase(ranges::remove_if(list, [&](const Entry &entry) {
+			return (entry.lastUsed < till);
+		}), end(list));
+		i = list.empty() ? _entries.erase(i) : (i + 1);
+	}
+	_count = 0;
+	for (const auto &[text, list] : _entries) {
+		_count += int(list.size());
+	}
+	DEBUG_LOG(("Dialogs Previews: %1 hits, %2 misses, %3 shared."
+		).arg(_hits
+		).arg(_misses
+		).arg(_count));
+}
+
+[[nodiscard]] SharedTexts &PreviewTexts() {
+	static auto result = SharedTexts();
+	return result;
+}
+
+} // namespace
 
 TextWithEntities DialogsPreviewText(TextWithEntities text) {
 	auto result = Ui::Text::Filtered(
@@ -120,8 +206,7 @@ struct MessageView::LoadingContext {
 };
 
 MessageView::MessageView()
-: _senderCache(st::dialogsTextWidthMin)
-, _textCache(st::dialogsTextWidthMin) {
+: _senderCache(st::dialogsTextWidthMin) {
 }
 
 MessageView::~MessageView() = default;
@@ -196,11 +281,23 @@ void MessageView::prepare(
 	auto textToCache = DialogsPreviewText(std::move(preview.text));
 	_hasPlainLinkAtBegin = !textToCache.entities.empty()
 		&& (textToCache.entities.front().type() == EntityType::Colorized);
-	_textCache.setMarkedText(
-		st::dialogsTextStyle,
-		std::move(textToCache),
-		DialogTextOptions(),
-		context);
+	if (ranges::contains(
+			textToCache.entities,
+			EntityType::CustomEmoji,
+			&EntityInText::type)) {
+		auto string = std::make_shared<Text::String>(
+			st::dialogsTextWidthMin);
+		string->setMarkedText(
+			st::dialogsTextStyle,
+			std::move(textToCache),
+			DialogTextOptions(),
+			context);
+		_textCache = std::move(string);
+		_hasCustomEmoji = true;
+	} else {
+		_textCache = PreviewTexts().lookup(std::move(textToCache));
+		_hasCustomEmoji = false;
+	}
 	_textCachedFor = item;
 	_imagesCache = std::move(preview.images);
 	if (!ranges::any_of(_imagesCache, &ItemPreviewImage::hasSpoiler)) {
@@ -222,6 +319,19 @@ void MessageView::prepare(
 	}
 }
 
+bool MessageView::hasHeavyPart() const {
+	return _hasCustomEmoji;
+}
+
+void MessageView::unloadHeavyPart() {
+	if (!_hasCustomEmoji) {
+		return;
+	}
+	_hasCustomEmoji = false;
+	_textCache = nullptr;
+	_textCachedFor = nullptr;
+}
+
 bool MessageView::isInTopicJump(int x, int y) const {
 	return _topics && _topics->isInTopicJumpArea(x, y);
 }
@@ -264,7 +374,7 @@ int MessageView::countWidth() const {
 			* (st::dialogsMiniPreview + st::dialogsMiniPreviewSkip))
 			+ st::dialogsMiniPreviewRight;
 	}
-	return result + _textCache.maxWidth();
+	return result + (_textCache ? _textCache->maxWidth() : 0);
 }
 
 void MessageView::paint(
@@ -378,8 +488,8 @@ void MessageView::paint(
 	// Style of _textCache.
 	static const auto ellipsisWidth = st::dialogsTextStyle.font->width(
 		kQEllipsis);
-	if (rect.width() > ellipsisWidth) {
-		_textCache.draw(p, {
+	if (_textCache && rect.width() > ellipsisWidth) {
+		_textCache->draw(p, {
 			.position = rect.topLeft(),
 			.availableWidth = rect.width(),
 			.palette = palette,
@@ -389,7 +499,7 @@ void MessageView::paint(
 			.pausedSpoiler = pausedSpoiler,
 			.elisionHeight = rect.height(),
 		});
-		rect.setLeft(rect.x() + _textCache.maxWidth());
+		rect.setLeft(rect.x() + _textCache->maxWidth());
 	}
 	if (jump1) {
 		const auto position = st::forumDialogJumpArrowPosition
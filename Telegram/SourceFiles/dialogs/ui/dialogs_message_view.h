@@ -63,6 +63,10 @@ public:
 		Fn<void()> customEmojiRepaint,
 		ToPreviewOptions options);
 
+	// Custom emoji keep their frames while the preview text holds them.
+	[[nodiscard]] bool hasHeavyPart() const;
+	void unloadHeavyPart();
+
 	void paint(
 		Painter &p,
 		const QRect &geometry,
@@ -89,12 +93,13 @@ private:
 	mutable const HistoryItem *_textCachedFor = nullptr;
 	mutable Text::String _senderCache;
 	mutable std::unique_ptr<TopicsView> _topics;
-	mutable Text::String _textCache;
+	mutable std::shared_ptr<const Text::String> _textCache;
 	mutable std::vector<ItemPreviewImage> _imagesCache;
 	mutable std::unique_ptr<SpoilerAnimation> _spoiler;
 	mutable std::unique_ptr<LoadingContext> _loadingContext;
 	mutable const style::DialogsMiniIcon *_leftIcon = nullptr;
 	mutable bool _hasPlainLinkAtBegin = false;
+	mutable bool _hasCustomEmoji = false;
 
 };
 
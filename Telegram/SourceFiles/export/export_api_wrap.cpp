@@ -349,7 +349,8 @@ auto ApiWrap::mainRequest(Request &&request) {
 	auto original = std::move(_mtp.request(MTPInvokeWithTakeout<Request>(
 		MTP_long(*_takeoutId),
 		std::forward<Request>(request)
-	)).toDC(MTP::ShiftDcId(0, MTP::kExportDcShift)));
+	)).toDC(MTP::ShiftDcId(0, MTP::kExportDcShift)).priority(
+		MTP::RequestPriority::Bulk));
 
 	return RequestBuilder<MTPInvokeWithTakeout<Request>>(
 		std::move(original),
@@ -401,7 +402,8 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int64 offset) {
 		} else {
 			error(std::move(result));
 		}
-	}).toDC(MTP::ShiftDcId(location.dcId, MTP::kExportMediaDcShift)));
+	}).toDC(MTP::ShiftDcId(location.dcId, MTP::kExportMediaDcShift)).priority(
+		MTP::RequestPriority::Bulk));
 }
 
 ApiWrap::ApiWrap(QPointer<MTP::Instance> weak, Fn<void(FnMut<void()>)> runner)
@@ -14,12 +14,14 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history_inner_widget.h"
 #include "history/history_item.h"
 #include "history/history_item_components.h"
+#include "history/history_item_edition.h"
 #include "history/history_item_helpers.h"
 #include "history/history_translation.h"
 #include "history/history_unread_things.h"
 #include "core/ui_integration.h"
 #include "dialogs/ui/dialogs_layout.h"
 #include "data/business/data_shortcut_messages.h"
+#include "data/components/memory_manager.h"
 #include "data/components/scheduled_messages.h"
 #include "data/components/sponsored_messages.h"
 #include "data/components/top_peers.h"
@@ -77,6 +79,9 @@ namespace {
 
 constexpr auto kNewBlockEachMessage = 50;
 constexpr auto kSkipCloudDraftsFor = TimeId(2);
+constexpr auto kStaleHeightsMinCount = 200;
+constexpr auto kStaleHeightsCheckEach = 16;
+constexpr auto kNewElementsAround = 30;
 
 using UpdateFlag = Data::HistoryUpdate::Flag;
 
@@ -525,6 +530,7 @@ void History::destroyMessage(not_null<HistoryItem*> item) {
 	if (item->isSending()) {
 		session().api().cancelLocalItem(item);
 	}
+	_provisionalItems.remove(item);
 
 	const auto documentToCancel = [&] {
 		const auto media = item->isAdminLogEntry()
@@ -1305,6 +1311,9 @@ HistoryItem *History::latestSendingMessage() const {
 }
 
 HistoryBlock *History::prepareBlockForAddingItem() {
+	if (blocks.empty()) {
+		session().memoryManager().touch(this);
+	}
 	if (isBuildingFrontBlock()) {
 		if (_buildingFrontBlock->block) {
 			return _buildingFrontBlock->block;
@@ -1384,6 +1393,62 @@ void History::addOlderSlice(const QVector<MTPMessage> &slice) {
 	checkLastMessage();
 }
 
+void History::addProvisionalSlice(const QVector<MTPMessage> &slice) {
+	Expects(isEmpty());
+
+	auto fresh = base::flat_set<MsgId>();
+	for (const auto &message : slice) {
+		const auto id = IdFromMessage(message);
+		if (!owner().message(peer, id)) {
+			fresh.emplace(id);
+		}
+	}
+	if (fresh.empty()) {
+		return;
+	}
+	const auto added = createItems(slice);
+	for (const auto &item : added) {
+		if (fresh.contains(item->id)) {
+			_provisionalItems.emplace(item);
+		}
+	}
+	startBuildingFrontBlock(added.size());
+	for (const auto &item : added) {
+		addItemToBlock(item);
+	}
+	finishBuildingFrontBlock();
+}
+
+void History::discardProvisionalSlice(const QVector<MTPMessage> &actual) {
+	if (_provisionalItems.empty()) {
+		return;
+	}
+	auto provisional = base::take(_provisionalItems);
+	const auto loadedAtTop = _loadedAtTop;
+	const auto loadedAtBottom = _loadedAtBottom;
+	clear(ClearType::Unload);
+	_loadedAtTop = loadedAtTop;
+	_loadedAtBottom = loadedAtBottom;
+
+	// Keep the items that are still there, the server slice
+	// will reuse them, but make them up to date first.
+	for (const auto &message : actual) {
+		const auto item = owner().message(peer, IdFromMessage(message));
+		if (!item || !provisional.remove(item)) {
+			continue;
+		}
+		message.match([](const MTPDmessageEmpty &) {
+		}, [&](const MTPDmessageService &data) {
+			item->applyEdition(data);
+		}, [&](const MTPDmessage &data) {
+			item->applyEdition(HistoryMessageEdition(&session(), data));
+		});
+	}
+	for (const auto &item : provisional) {
+		item->destroy();
+	}
+}
+
 void History::addCreatedOlderSlice(
 		const std::vector<not_null<HistoryItem*>> &items) {
 	startBuildingFrontBlock(items.size());
@@ -3013,7 +3078,10 @@ HistoryItem *History::lastEditableMessage() const {
 	return nullptr;
 }
 
-void History::resizeToWidth(int newWidth) {
+void History::resizeToWidth(
+		int newWidth,
+		int visibleTop,
+		int visibleBottom) {
 	using Request = HistoryBlock::ResizeRequest;
 	const auto request = (_flags & Flag::PendingAllItemsResize)
 		? Request::ReinitAll
@@ -3025,6 +3093,13 @@ void History::resizeToWidth(int newWidth) {
 	}
 	_flags &= ~(Flag::HasPendingResizedItems | Flag::PendingAllItemsResize);
 
+	if (request == Request::ReinitAll) {
+		_flags &= ~Flag::HasStaleHeights;
+	} else if (request == Request::ResizeAll) {
+		markStaleHeights(visibleTop, visibleBottom);
+	} else {
+		estimateNewHeights(visibleTop, visibleBottom);
+	}
 	_width = newWidth;
 	int y = 0;
 	for (const auto &block : blocks) {
@@ -3034,6 +3109,172 @@ void History::resizeToWidth(int newWidth) {
 	_height = y;
 }
 
+void History::markStaleHeights(int visibleTop, int visibleBottom) {
+	auto count = 0;
+	for (const auto &block : blocks) {
+		count += int(block->messages.size());
+	}
+	const auto visibleHeight = visibleBottom - visibleTop;
+	const auto defer = (_width > 0)
+		&& (visibleHeight > 0)
+		&& (count >= kStaleHeightsMinCount);
+	if (!defer && !hasStaleHeights()) {
+		return;
+	}
+
+	// Keep a screen above and a screen below the visible range exact.
+	const auto from = visibleTop - visibleHeight;
+	const auto till = visibleBottom + visibleHeight;
+	auto stale = false;
+	for (const auto &block : blocks) {
+		for (const auto &message : block->messages) {
+			const auto top = block->y() + message->y();
+			const auto far = defer
+				&& ((top + message->height() <= from) || (top >= till));
+			message->setStaleHeight(far);
+			stale |= far;
+		}
+	}
+	if (stale) {
+		_flags |= Flag::HasStaleHeights;
+	} else {
+		_flags &= ~Flag::HasStaleHeights;
+	}
+}
+
+void History::estimateNewHeights(int visibleTop, int visibleBottom) {
+	const auto visibleHeight = visibleBottom - visibleTop;
+	if (_width <= 0 || visibleHeight <= 0) {
+		return;
+	}
+	// Placeholders already have their estimate, don't redo it each pass.
+	const auto isNew = [](not_null<Element*> view) {
+		return view->pendingResize()
+			&& !view->width()
+			&& !view->staleHeight();
+	};
+
+	// Find the laid out elements around the visible range.
+	const auto from = visibleTop - visibleHeight;
+	const auto till = visibleBottom + visibleHeight;
+	auto index = 0;
+	auto first = -1;
+	auto last = -1;
+	auto laidOut = 0;
+	auto heights = int64(0);
+	auto hasNew = false;
+	for (const auto &block : blocks) {
+		for (const auto &message : block->messages) {
+			if (isNew(message.get())) {
+				hasNew = true;
+			} else if (!message->isPlaceholder()) {
+				const auto top = block->y() + message->y();
+				const auto height = message->height();
+				if (top + height > from && top < till) {
+					if (first < 0) {
+						first = index;
+					}
+					last = index;
+				}
+				heights += height;
+				++laidOut;
+			}
+			++index;
+		}
+	}
+	if (!hasNew || first < 0) {
+		return;
+	}
+	const auto estimate = int(heights / laidOut);
+	first -= kNewElementsAround;
+	last += kNewElementsAround;
+	index = 0;
+	for (const auto &block : blocks) {
+		for (const auto &message : block->messages) {
+			if ((index < first || index > last) && isNew(message.get())) {
+				message->setStaleHeight(true);
+				message->setEstimatedHeight(estimate);
+				_flags |= Flag::HasStaleHeights;
+			}
+			++index;
+		}
+	}
+}
+
+bool History::hasStaleHeights() const {
+	return _flags & Flag::HasStaleHeights;
+}
+
+bool History::resizeStaleHeights(crl::time till) {
+	if (!hasStaleHeights()) {
+		return true;
+	}
+
+	// Newest messages are the most likely to be scrolled to.
+	auto checked = 0;
+	auto finished = true;
+	for (const auto &block : ranges::views::reverse(blocks)) {
+		for (const auto &message : ranges::views::reverse(block->messages)) {
+			if (!message->staleHeight()) {
+				continue;
+			} else if (!(++checked % kStaleHeightsCheckEach)
+				&& crl::now() >= till) {
+				finished = false;
+				break;
+			}
+			message->setStaleHeight(false);
+			message->resizeGetHeight(_width);
+		}
+		if (!finished) {
+			break;
+		}
+	}
+	if (finished) {
+		_flags &= ~Flag::HasStaleHeights;
+	}
+	recountBlocksGeometry();
+	return finished;
+}
+
+bool History::resizeStaleHeights(int from, int till) {
+	if (!hasStaleHeights()) {
+		return false;
+	}
+	auto resized = false;
+	for (const auto &block : blocks) {
+		const auto top = block->y();
+		if (top >= till) {
+			break;
+		} else if (top + block->height() <= from) {
+			continue;
+		}
+		for (const auto &message : block->messages) {
+			const auto messageTop = top + message->y();
+			if (messageTop >= till) {
+				break;
+			} else if (message->staleHeight()
+				&& messageTop + message->height() > from) {
+				message->setStaleHeight(false);
+				message->resizeGetHeight(_width);
+				resized = true;
+			}
+		}
+	}
+	if (resized) {
+		recountBlocksGeometry();
+	}
+	return resized;
+}
+
+void History::recountBlocksGeometry() {
+	auto y = 0;
+	for (const auto &block : blocks) {
+		block->setY(y);
+		y += block->recountHeight();
+	}
+	_height = y;
+}
+
 void History::forceFullResize() {
 	_width = 0;
 	_flags |= Flag::HasPendingResizedItems;
@@ -3585,18 +3826,21 @@ int HistoryBlock::resizeGetHeight(int newWidth, ResizeRequest request) {
 	if (request == ResizeRequest::ReinitAll) {
 		for (const auto &message : messages) {
 			message->setY(y);
+			message->setStaleHeight(false);
 			message->initDimensions();
 			y += message->resizeGetHeight(newWidth);
 		}
 	} else if (request == ResizeRequest::ResizeAll) {
 		for (const auto &message : messages) {
 			message->setY(y);
-			y += message->resizeGetHeight(newWidth);
+			y += message->staleHeight()
+				? message->height()
+				: message->resizeGetHeight(newWidth);
 		}
 	} else {
 		for (const auto &message : messages) {
 			message->setY(y);
-			y += message->pendingResize()
+			y += (message->pendingResize() && !message->staleHeight())
 				? message->resizeGetHeight(newWidth)
 				: message->height();
 		}
@@ -3605,6 +3849,16 @@ int HistoryBlock::resizeGetHeight(int newWidth, ResizeRequest request) {
 	return _height;
 }
 
+int HistoryBlock::recountHeight() {
+	auto y = 0;
+	for (const auto &message : messages) {
+		message->setY(y);
+		y += message->height();
+	}
+	_height = y;
+	return _height;
+}
+
 void HistoryBlock::remove(not_null<Element*> view) {
 	Expects(view->block() == this);
 
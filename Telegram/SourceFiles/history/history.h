@@ -199,6 +199,14 @@ public:
 	void addOlderSlice(const QVector<MTPMessage> &slice);
 	void addNewerSlice(const QVector<MTPMessage> &slice);
 
+	// Messages from the local cache, shown until the server slice arrives.
+	// They don't affect shared media, unread things or the loaded state.
+	void addProvisionalSlice(const QVector<MTPMessage> &slice);
+	void discardProvisionalSlice(const QVector<MTPMessage> &actual);
+	[[nodiscard]] bool hasProvisionalSlice() const {
+		return !_provisionalItems.empty();
+	}
+
 	void newItemAdded(not_null<HistoryItem*> item);
 
 	void registerClientSideMessage(not_null<HistoryItem*> item);
@@ -279,7 +287,19 @@ public:
 	MsgId msgIdForRead() const;
 	HistoryItem *lastEditableMessage() const;
 
-	void resizeToWidth(int newWidth);
+	// When the width changes in a long history only the elements around
+	// the given visible range (in the previous layout) are resized, the
+	// rest keep their heights until resizeStaleHeights() gets to them.
+	// New elements far from that range get estimated heights the same way.
+	void resizeToWidth(
+		int newWidth,
+		int visibleTop = 0,
+		int visibleBottom = 0);
+	[[nodiscard]] bool hasStaleHeights() const;
+	// Returns false if the time ran out before all of them were resized.
+	bool resizeStaleHeights(crl::time till);
+	// Returns true if some elements in the given range were resized.
+	bool resizeStaleHeights(int from, int till);
 	void forceFullResize();
 	int height() const;
 
@@ -455,6 +475,7 @@ private:
 		FakeUnreadWhileOpened = (1 << 4),
 		HasPinnedMessages = (1 << 5),
 		ResolveChatListMessage = (1 << 6),
+		HasStaleHeights = (1 << 7),
 	};
 	using Flags = base::flags<Flag>;
 	friend inline constexpr auto is_flag_type(Flag) {
@@ -513,6 +534,9 @@ private:
 		const std::vector<not_null<HistoryItem*>> &items);
 
 	void checkForLoadedAtTop(not_null<HistoryItem*> added);
+	void markStaleHeights(int visibleTop, int visibleBottom);
+	void estimateNewHeights(int visibleTop, int visibleBottom);
+	void recountBlocksGeometry();
 	void mainViewRemoved(
 		not_null<HistoryBlock*> block,
 		not_null<Element*> view);
@@ -597,6 +621,7 @@ private:
 	std::optional<HistoryItem*> _lastMessage;
 	std::optional<HistoryItem*> _lastServerMessage;
 	base::flat_set<not_null<HistoryItem*>> _clientSideMessages;
+	base::flat_set<not_null<HistoryItem*>> _provisionalItems;
 	std::unordered_set<std::unique_ptr<HistoryItem>> _items;
 
 	std::unique_ptr<Data::HistoryMessages> _messages;
@@ -652,6 +677,7 @@ public:
 	void refreshView(not_null<Element*> view);
 
 	int resizeGetHeight(int newWidth, ResizeRequest request);
+	int recountHeight();
 	int y() const {
 		return _y;
 	}
@@ -59,6 +59,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "chat_helpers/emoji_interactions.h"
 #include "history/history_widget.h"
 #include "history/view/history_view_translate_tracker.h"
+#include "history/view/history_view_scroll_paint_cache.h"
 #include "base/platform/base_platform_info.h"
 #include "base/qt/qt_common_adapters.h"
 #include "base/qt/qt_key_modifiers.h"
@@ -361,6 +362,7 @@ HistoryInner::HistoryInner(
 	[=](not_null<const Element*> view) { return itemTop(view); }))
 , _migrated(history->migrateFrom())
 , _translateTracker(std::make_unique<HistoryView::TranslateTracker>(history))
+, _scrollPaintCache(std::make_unique<HistoryView::ScrollPaintCache>())
 , _pathGradient(
 	HistoryView::MakePathShiftGradient(
 		controller->chatStyle(),
@@ -670,6 +672,9 @@ void HistoryInner::repaintItem(const HistoryItem *item) {
 }
 
 void HistoryInner::repaintItem(const Element *view) {
+	if (view) {
+		_scrollPaintCache->invalidate(view);
+	}
 	if (_widget->skipItemRepaint()) {
 		return;
 	}
@@ -1111,6 +1116,24 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 		seltoy += _dragSelTo->height();
 	}
 
+	const auto useScrollCache = HistoryView::ScrollPaintCache::Enabled()
+		&& !inSelectionMode()
+		&& _widget->skipItemRepaint();
+	if (!useScrollCache) {
+		_scrollPaintCache->clear();
+	}
+	const auto drawView = [&](not_null<Element*> view, int top) {
+		if (view->isPlaceholder()) {
+			// HistoryWidget lays out visible placeholders before painting,
+			// this one wasn't laid out yet and wasn't seen by the user.
+			return;
+		} else if (!useScrollCache
+			|| !_scrollPaintCache->paint(p, view, context)) {
+			view->draw(p, context);
+		}
+		processPainted(view, top, view->height());
+	};
+
 	const auto hdrawtop = historyDrawTop();
 	if (mtop >= 0) {
 		auto iBlock = (_curHistory == _migrated ? _curBlock : (_migrated->blocks.size() - 1));
@@ -1130,8 +1153,7 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 				selfromy - mtop,
 				seltoy - mtop);
 			context.highlight = _widget->itemHighlight(view->data());
-			view->draw(p, context);
-			processPainted(view, top, height);
+			drawView(view, top);
 
 			top += height;
 			context.translate(0, -height);
@@ -1176,8 +1198,7 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 					selfromy - htop,
 					seltoy - htop);
 				context.highlight = _widget->itemHighlight(item);
-				view->draw(p, context);
-				processPainted(view, top, height);
+				drawView(view, top);
 			}
 			top += height;
 			context.translate(0, -height);
@@ -1916,6 +1937,7 @@ void HistoryInner::viewRemoved(not_null<const Element*> view) {
 	refresh(_dragSelFrom);
 	refresh(_dragSelTo);
 	refresh(_scrollDateLastItem);
+	_scrollPaintCache->invalidate(view);
 }
 
 void HistoryInner::mouseActionFinish(
@@ -3234,9 +3256,22 @@ void HistoryInner::recountHistoryGeometry() {
 
 	updateBotInfo(false);
 
-	_history->resizeToWidth(_contentWidth);
+	// Visible range in the coordinates of the previous layout.
+	const auto resize = [&](not_null<History*> history, int top) {
+		if (top >= 0) {
+			history->resizeToWidth(
+				_contentWidth,
+				_visibleAreaTop - top,
+				_visibleAreaBottom - top);
+		} else {
+			history->resizeToWidth(_contentWidth);
+		}
+	};
+	const auto wasHistoryTop = historyTop();
+	const auto wasMigratedTop = migratedTop();
+	resize(_history, wasHistoryTop);
 	if (_migrated) {
-		_migrated->resizeToWidth(_contentWidth);
+		resize(_migrated, wasMigratedTop);
 	}
 
 	// With migrated history we perhaps do not need to display
@@ -3283,6 +3318,32 @@ void HistoryInner::recountHistoryGeometry() {
 	}
 }
 
+bool HistoryInner::hasStaleHeights() const {
+	return _history->hasStaleHeights()
+		|| (_migrated && _migrated->hasStaleHeights());
+}
+
+void HistoryInner::resizeStaleHeights(crl::time till) {
+	if (_history->resizeStaleHeights(till) && _migrated) {
+		_migrated->resizeStaleHeights(till);
+	}
+}
+
+bool HistoryInner::resizeStaleHeights(int visibleTop, int visibleBottom) {
+	auto resized = false;
+	if (const auto htop = historyTop(); htop >= 0) {
+		resized |= _history->resizeStaleHeights(
+			visibleTop - htop,
+			visibleBottom - htop);
+	}
+	if (const auto mtop = migratedTop(); mtop >= 0) {
+		resized |= _migrated->resizeStaleHeights(
+			visibleTop - mtop,
+			visibleBottom - mtop);
+	}
+	return resized;
+}
+
 void HistoryInner::updateBotInfo(bool recount) {
 	if (!_aboutView) {
 		return;
@@ -3816,7 +3877,7 @@ void HistoryInner::mouseActionUpdate() {
 	const auto reactionState = _reactionsManager->buttonTextState(point);
 	const auto reactionItem = session().data().message(reactionState.itemId);
 	const auto reactionView = viewByItem(reactionItem);
-	const auto view = reactionView
+	const auto found = reactionView
 		? reactionView
 		: (_aboutView
 			&& _aboutView->view()
@@ -3826,6 +3887,7 @@ void HistoryInner::mouseActionUpdate() {
 		: (_curHistory && !_curHistory->isEmpty())
 		? _curHistory->blocks[_curBlock]->messages[_curItem].get()
 		: nullptr;
+	const auto view = (found && !found->isPlaceholder()) ? found : nullptr;
 	const auto item = view ? view->data().get() : nullptr;
 	if (view) {
 		const auto changed = (Element::Moused() != view);
@@ -34,6 +34,7 @@ enum class PointState : char;
 class EmptyPainter;
 class Element;
 class TranslateTracker;
+class ScrollPaintCache;
 struct PinnedId;
 struct SelectedQuote;
 class AboutView;
@@ -120,6 +121,9 @@ public:
 	void changeItemsRevealHeight(int revealHeight);
 	void checkActivation();
 	void recountHistoryGeometry();
+	[[nodiscard]] bool hasStaleHeights() const;
+	void resizeStaleHeights(crl::time till);
+	bool resizeStaleHeights(int visibleTop, int visibleBottom);
 	void updateSize();
 	void setShownPinned(HistoryItem *item);
 
@@ -459,6 +463,7 @@ private:
 	std::unique_ptr<HistoryView::AboutView> _aboutView;
 	std::unique_ptr<HistoryView::EmptyPainter> _emptyPainter;
 	std::unique_ptr<HistoryView::TranslateTracker> _translateTracker;
+	std::unique_ptr<HistoryView::ScrollPaintCache> _scrollPaintCache;
 
 	mutable History *_curHistory = nullptr;
 	mutable int _curBlock = 0;
@@ -158,8 +158,130 @@ template <typename T>
 	return { Ui::FillAmountAndCurrency(amount, currency) };
 }
 
+// Loading a chat creates and destroys items by thousands, so they are
+// placed in slabs of equal blocks instead of separate heap allocations.
+// Each slab counts its live items and is freed once it becomes empty,
+// only one empty slab is kept for the next allocations.
+// Items live only on the main thread, so the slabs are not guarded.
+class ItemSlabs final {
+public:
+	[[nodiscard]] void *allocate();
+	void free(void *pointer);
+
+private:
+	struct Slab;
+	struct Block {
+		union {
+			Block *next;
+			alignas(HistoryItem) std::byte data[sizeof(HistoryItem)];
+		};
+		Slab *slab = nullptr;
+	};
+	static constexpr auto kSlabSize = 256;
+	struct Slab {
+		std::array<Block, kSlabSize> blocks;
+		Block *free = nullptr;
+		int used = 0;
+	};
+
+	[[nodiscard]] not_null<Slab*> createSlab();
+	void destroySlab(not_null<Slab*> slab);
+
+	std::vector<std::unique_ptr<Slab>> _slabs;
+	base::flat_set<not_null<Slab*>> _withFree;
+	Slab *_current = nullptr;
+
+};
+
+auto ItemSlabs::createSlab() -> not_null<Slab*> {
+	auto slab = std::make_unique<Slab>();
+	for (auto i = 0; i != kSlabSize; ++i) {
+		auto &block = slab->blocks[i];
+		block.slab = slab.get();
+		block.next = (i + 1 < kSlabSize) ? &slab->blocks[i + 1] : nullptr;
+	}
+	slab->free = &slab->blocks[0];
+	const auto result = slab.get();
+	_slabs.push_back(std::move(slab));
+	_withFree.emplace(result);
+	return result;
+}
+
+void ItemSlabs::destroySlab(not_null<Slab*> slab) {
+	if (_current == slab) {
+		_current = nullptr;
+	}
+	_withFree.remove(slab);
+	const auto i = ranges::find(
+		_slabs,
+		slab.get(),
+		&std::unique_ptr<Slab>::get);
+	Assert(i != end(_slabs));
+	_slabs.erase(i);
+}
+
+void *ItemSlabs::allocate() {
+	if (!_current || !_current->free) {
+		// Prefer the fullest slabs, so that the emptier ones may drain.
+		_current = nullptr;
+		for (const auto candidate : _withFree) {
+			if (!_current || candidate->used > _current->used) {
+				_current = candidate;
+			}
+		}
+		if (!_current) {
+			_current = createSlab();
+		}
+	}
+	const auto slab = _current;
+	const auto result = std::exchange(slab->free, slab->free->next);
+	if (++slab->used == kSlabSize) {
+		_withFree.remove(slab);
+	}
+	return result->data;
+}
+
+void ItemSlabs::free(void *pointer) {
+	const auto block = static_cast<Block*>(pointer);
+	const auto slab = block->slab;
+	Expects(slab->used > 0);
+
+	if (slab->used == kSlabSize) {
+		_withFree.emplace(slab);
+	}
+	block->next = slab->free;
+	slab->free = block;
+	if (--slab->used) {
+		return;
+	}
+	for (const auto other : _withFree) {
+		if (other != slab && !other->used) {
+			// Keep only one empty slab for the next allocations.
+			destroySlab(slab);
+			return;
+		}
+	}
+}
+
+[[nodiscard]] ItemSlabs &Slabs() {
+	static auto result = ItemSlabs();
+	return result;
+}
+
 } // namespace
 
+void *HistoryItem::operator new(std::size_t size) {
+	Expects(size == sizeof(HistoryItem));
+
+	return Slabs().allocate();
+}
+
+void HistoryItem::operator delete(void *pointer) {
+	if (pointer) {
+		Slabs().free(pointer);
+	}
+}
+
 void HistoryItem::HistoryItem::Destroyer::operator()(HistoryItem *value) {
 	if (value) {
 		value->destroy();
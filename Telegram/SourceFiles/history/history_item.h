@@ -178,6 +178,10 @@ public:
 		not_null<GameData*> game);
 	~HistoryItem();
 
+	// Items are taken from slabs, see ItemSlabs in history_item.cpp.
+	static void *operator new(std::size_t size);
+	static void operator delete(void *pointer);
+
 	struct Destroyer {
 		void operator()(HistoryItem *value);
 	};
@@ -56,6 +56,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/call_delayed.h"
 #include "data/business/data_shortcut_messages.h"
 #include "data/components/credits.h"
+#include "data/components/memory_manager.h"
 #include "data/components/scheduled_messages.h"
 #include "data/components/sponsored_messages.h"
 #include "data/notify/data_notify_settings.h"
@@ -74,6 +75,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_chat_filters.h"
 #include "data/data_file_origin.h"
 #include "data/data_histories.h"
+#include "data/data_history_cache.h"
 #include "data/data_group_call.h"
 #include "data/data_message_reactions.h"
 #include "data/data_peer_values.h" // Data::AmPremiumValue.
@@ -193,6 +195,8 @@ constexpr auto kMessagesPerPage = 50;
 constexpr auto kPreloadHeightsCount = 3; // when 3 screens to scroll left make a preload request
 constexpr auto kScrollToVoiceAfterScrolledMs = 1000;
 constexpr auto kSkipRepaintWhileScrollMs = 100;
+constexpr auto kResizeStaleHeightsBudget = crl::time(8);
+constexpr auto kResizeVisibleStaleHeightsAttempts = 4;
 constexpr auto kShowMembersDropdownTimeoutMs = 300;
 constexpr auto kDisplayEditTimeWarningMs = 300 * 1000;
 constexpr auto kFullDayInMs = 86400 * 1000;
@@ -245,6 +249,7 @@ HistoryWidget::HistoryWidget(
 	controller->chatStyle()->value(lifetime(), st::historyScroll),
 	false)
 , _updateHistoryItems([=] { updateHistoryItemsByTimer(); })
+, _resizeStaleHeightsTimer([=] { resizeStaleHeights(); })
 , _cornerButtons(
 	_scroll.data(),
 	controller->chatStyle(),
@@ -2518,6 +2523,7 @@ void HistoryWidget::showHistory(
 		updateTopBarChooseForReport();
 
 		_updateHistoryItems.cancel();
+		_resizeStaleHeightsTimer.cancel();
 
 		setupTranslateBar();
 		setupPinnedTracker();
@@ -2637,6 +2643,7 @@ void HistoryWidget::setHistory(History *history) {
 			history->owner().unloadHeavyViewParts(
 				history->delegateMixin()->delegate());
 			history->forceFullResize();
+			history->session().memoryManager().touch(history);
 		}
 	};
 
@@ -2652,6 +2659,10 @@ void HistoryWidget::setHistory(History *history) {
 	if (history) {
 		_history = history;
 		_migrated = _history ? _history->migrateFrom() : nullptr;
+		session().memoryManager().touch(_history);
+		if (_migrated) {
+			session().memoryManager().touch(_migrated);
+		}
 		registerDraftSource();
 		if (_history) {
 			setupPreview();
@@ -2812,6 +2823,11 @@ void HistoryWidget::clearAllLoadRequests() {
 		histories.cancelRequest(_firstLoadRequest);
 		_firstLoadRequest = 0;
 	}
+	if (_cachedSliceRequest) {
+		histories.cancelRequest(_cachedSliceRequest);
+		_cachedSliceRequest = 0;
+		_history->discardProvisionalSlice({});
+	}
 	if (_preloadRequest) {
 		histories.cancelRequest(_preloadRequest);
 		_preloadRequest = 0;
@@ -3475,6 +3491,10 @@ void HistoryWidget::messagesFailed(const MTP::Error &error, int requestId) {
 	} else if (_firstLoadRequest == requestId) {
 		_firstLoadRequest = 0;
 		closeCurrent();
+	} else if (_cachedSliceRequest == requestId) {
+		_cachedSliceRequest = 0;
+		_history->discardProvisionalSlice({});
+		closeCurrent();
 	} else if (_delayedShowAtRequest == requestId) {
 		_delayedShowAtRequest = 0;
 	}
@@ -3497,6 +3517,8 @@ void HistoryWidget::messagesReceived(
 			_preloadDownRequest = 0;
 		} else if (_firstLoadRequest == requestId) {
 			_firstLoadRequest = 0;
+		} else if (_cachedSliceRequest == requestId) {
+			_cachedSliceRequest = 0;
 		} else if (_delayedShowAtRequest == requestId) {
 			_delayedShowAtRequest = 0;
 		}
@@ -3549,13 +3571,23 @@ void HistoryWidget::messagesReceived(
 		if (_history->loadedAtBottom()) {
 			checkActivation();
 		}
-	} else if (_firstLoadRequest == requestId) {
+	} else if (_firstLoadRequest == requestId
+		|| _cachedSliceRequest == requestId) {
+		if (_cachedSliceRequest) {
+			_firstLoadRequest = base::take(_cachedSliceRequest);
+			_history->discardProvisionalSlice(*histList);
+		}
 		if (toMigrated) {
 			_history->clear(History::ClearType::Unload);
 		} else if (_migrated) {
 			_migrated->clear(History::ClearType::Unload);
 		}
 		addMessagesToFront(peer, *histList);
+		if (!toMigrated && _history->loadedAtBottom()) {
+			_history->owner().historyCache().rememberSlice(
+				_history,
+				*histList);
+		}
 		_firstLoadRequest = 0;
 		if (_history->loadedAtTop() && _history->isEmpty() && count > 0) {
 			firstLoadMessages();
@@ -3624,6 +3656,7 @@ bool HistoryWidget::markingContentsRead() const {
 		&& _list
 		&& _historyInited
 		&& !_firstLoadRequest
+		&& !_cachedSliceRequest
 		&& !_delayedShowAtRequest
 		&& !_showAnimation
 		&& controller()->widget()->markingAsRead();
@@ -3683,6 +3716,9 @@ void HistoryWidget::firstLoadMessages() {
 	const auto history = from;
 	const auto type = Data::Histories::RequestType::History;
 	auto &histories = history->owner().histories();
+
+	// The request may be moved to _cachedSliceRequest before it is done.
+	const auto requestId = std::make_shared<int>();
 	_firstLoadRequest = histories.sendRequest(history, type, [=](Fn<void()> finish) {
 		return history->session().api().request(MTPmessages_GetHistory(
 			history->peer->input,
@@ -3694,13 +3730,44 @@ void HistoryWidget::firstLoadMessages() {
 			MTP_int(minId),
 			MTP_long(historyHash)
 		)).done([=](const MTPmessages_Messages &result) {
-			messagesReceived(history->peer, result, _firstLoadRequest);
+			messagesReceived(history->peer, result, *requestId);
 			finish();
 		}).fail([=](const MTP::Error &error) {
-			messagesFailed(error, _firstLoadRequest);
+			messagesFailed(error, *requestId);
 			finish();
 		}).send();
 	});
+	*requestId = _firstLoadRequest;
+
+	if (history == _history
+		&& !offsetId
+		&& _history->isEmpty()
+		&& (_showAtMsgId == ShowAtTheEndMsgId
+			|| _showAtMsgId == ShowAtUnreadMsgId)) {
+		showCachedSlice();
+	}
+}
+
+void HistoryWidget::showCachedSlice() {
+	if (!Data::HistoryCache::Enabled()) {
+		return;
+	}
+	const auto history = _history;
+	const auto requestId = _firstLoadRequest;
+	auto &cache = history->owner().historyCache();
+	cache.load(history, crl::guard(this, [=](QVector<MTPMessage> &&list) {
+		if (_history != history
+			|| _firstLoadRequest != requestId
+			|| !history->isEmpty()
+			|| list.isEmpty()) {
+			return;
+		}
+		history->addProvisionalSlice(list);
+		if (history->hasProvisionalSlice()) {
+			_cachedSliceRequest = base::take(_firstLoadRequest);
+			historyLoaded();
+		}
+	}));
 }
 
 void HistoryWidget::loadMessages() {
@@ -3942,6 +4009,7 @@ void HistoryWidget::visibleAreaUpdated() {
 		const auto scrollTop = _scroll->scrollTop();
 		const auto scrollBottom = scrollTop + _scroll->height();
 		_list->visibleAreaUpdated(scrollTop, scrollBottom);
+		resizeVisibleStaleHeights();
 		controller()->floatPlayerAreaUpdated();
 		session().data().itemVisibilitiesUpdated();
 	}
@@ -3949,6 +4017,7 @@ void HistoryWidget::visibleAreaUpdated() {
 
 void HistoryWidget::preloadHistoryIfNeeded() {
 	if (_firstLoadRequest
+		|| _cachedSliceRequest
 		|| _delayedShowAtRequest
 		|| _scroll->isHidden()
 		|| !_peer
@@ -6385,6 +6454,38 @@ void HistoryWidget::updateHistoryGeometry(
 	}
 	const auto toY = std::clamp(newScrollTop, 0, _scroll->scrollTopMax());
 	synteticScrollToY(toY);
+
+	resizeVisibleStaleHeights();
+	if (_list->hasStaleHeights() && !_resizeStaleHeightsTimer.isActive()) {
+		_resizeStaleHeightsTimer.callOnce(0);
+	}
+}
+
+void HistoryWidget::resizeStaleHeights() {
+	if (!_list) {
+		return;
+	}
+	_list->resizeStaleHeights(crl::now() + kResizeStaleHeightsBudget);
+	updateHistoryGeometry();
+}
+
+void HistoryWidget::resizeVisibleStaleHeights() {
+	if (_resizingVisibleStaleHeights || !_list->hasStaleHeights()) {
+		return;
+	}
+
+	// Each pass keeps the top visible item in place, which may bring
+	// other stale elements into view, so repeat it a few times.
+	_resizingVisibleStaleHeights = true;
+	for (auto i = 0; i != kResizeVisibleStaleHeightsAttempts; ++i) {
+		const auto scrollTop = _scroll->scrollTop();
+		const auto scrollBottom = scrollTop + _scroll->height();
+		if (!_list->resizeStaleHeights(scrollTop, scrollBottom)) {
+			break;
+		}
+		updateHistoryGeometry();
+	}
+	_resizingVisibleStaleHeights = false;
 }
 
 void HistoryWidget::revealItemsCallback() {
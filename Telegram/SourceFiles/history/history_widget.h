@@ -386,6 +386,8 @@ private:
 
 	void handleScroll();
 	void updateHistoryItemsByTimer();
+	void resizeStaleHeights();
+	void resizeVisibleStaleHeights();
 
 	[[nodiscard]] Dialogs::EntryState computeDialogsEntryState() const;
 	void refreshTopBarActiveChat();
@@ -563,6 +565,7 @@ private:
 	void messagesReceived(not_null<PeerData*> peer, const MTPmessages_Messages &messages, int requestId);
 	void messagesFailed(const MTP::Error &error, int requestId);
 	void addMessagesToFront(not_null<PeerData*> peer, const QVector<MTPMessage> &messages);
+	void showCachedSlice();
 	void addMessagesToBack(not_null<PeerData*> peer, const QVector<MTPMessage> &messages);
 
 	void updateSendRestriction();
@@ -711,6 +714,7 @@ private:
 	int _showAtMsgHighlightPartOffsetHint = 0;
 
 	int _firstLoadRequest = 0; // Not real mtpRequestId.
+	int _cachedSliceRequest = 0; // First load, while showing cached slice.
 	int _preloadRequest = 0; // Not real mtpRequestId.
 	int _preloadDownRequest = 0; // Not real mtpRequestId.
 
@@ -735,6 +739,8 @@ private:
 	int _lastScrollTop = 0; // gifs optimization
 	crl::time _lastScrolled = 0;
 	base::Timer _updateHistoryItems;
+	base::Timer _resizeStaleHeightsTimer;
+	bool _resizingVisibleStaleHeights = false;
 
 	crl::time _lastUserScrolled = 0;
 	bool _synteticScrollEvent = false;
@@ -674,6 +674,28 @@ bool Element::pendingResize() const {
 	return _flags & Flag::NeedsResize;
 }
 
+void Element::setStaleHeight(bool stale) {
+	if (stale) {
+		_flags |= Flag::StaleHeight;
+	} else {
+		_flags &= ~Flag::StaleHeight;
+	}
+}
+
+bool Element::staleHeight() const {
+	return _flags & Flag::StaleHeight;
+}
+
+void Element::setEstimatedHeight(int height) {
+	Expects(pendingResize());
+
+	setCurrentSize({ 0, height });
+}
+
+bool Element::isPlaceholder() const {
+	return staleHeight() && !width();
+}
+
 bool Element::isAttachedToPrevious() const {
 	return _flags & Flag::AttachedToPrevious;
 }
@@ -321,6 +321,7 @@ public:
 		TopicRootReply           = 0x0400,
 		MediaOverriden           = 0x0800,
 		HeavyCustomEmoji         = 0x1000,
+		StaleHeight              = 0x2000,
 	};
 	using Flags = base::flags<Flag>;
 	friend inline constexpr auto is_flag_type(Flag) { return true; }
@@ -350,6 +351,14 @@ public:
 
 	void setPendingResize();
 	[[nodiscard]] bool pendingResize() const;
+
+	// Laid out for the previous width, see History::resizeToWidth().
+	void setStaleHeight(bool stale);
+	[[nodiscard]] bool staleHeight() const;
+
+	// Not laid out yet, only has an estimated height.
+	void setEstimatedHeight(int height);
+	[[nodiscard]] bool isPlaceholder() const;
 	[[nodiscard]] bool isUnderCursor() const;
 
 	[[nodiscard]] bool isLastAndSelfMessage() const;
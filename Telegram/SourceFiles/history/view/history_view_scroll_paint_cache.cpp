@@ -0,0 +1,136 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "history/view/history_view_scroll_paint_cache.h"
+
+#include "base/options.h"
+#include "history/view/history_view_element.h"
+#include "ui/chat/chat_style.h"
+#include "ui/painter.h"
+
+namespace HistoryView {
+namespace {
+
+constexpr auto kBytesLimit = int64(64 * 1024 * 1024);
+
+base::options::toggle CacheMessagesWhileScrolling({
+	.id = kOptionCacheMessagesWhileScrolling,
+	.name = "Cache messages while scrolling",
+	.description = "Paint static messages from images while scrolling.",
+});
+
+} // namespace
+
+const char kOptionCacheMessagesWhileScrolling[]
+	= "cache-messages-while-scrolling";
+
+bool ScrollPaintCache::Enabled() {
+	return CacheMessagesWhileScrolling.value();
+}
+
+bool ScrollPaintCache::Cacheable(
+		not_null<const Element*> view,
+		const Ui::ChatPaintContext &context) {
+	// Gradient bubbles depend on the position in the viewport and
+	// heavy parts (stickers, videos, custom emoji) are animated.
+	return !context.bubblesPattern
+		&& !context.highlight.opacity
+		&& !(context.reactionInfo && context.reactionInfo->effectPaint)
+		&& (context.skipDrawingParts
+			== Ui::ChatPaintContext::SkipDrawingParts::None)
+		&& (view->width() > 0)
+		&& (view->height() > 0)
+		&& !view->hasHeavyPart();
+}
+
+int64 ScrollPaintCache::ImageBytes(const QImage &image) {
+	return int64(image.bytesPerLine()) * image.height();
+}
+
+bool ScrollPaintCache::paint(
+		QPainter &p,
+		not_null<const Element*> view,
+		const Ui::ChatPaintContext &context) {
+	if (!Cacheable(view, context)) {
+		invalidate(view);
+		return false;
+	}
+	const auto ratio = style::DevicePixelRatio();
+	const auto size = QSize(view->width(), view->height()) * ratio;
+	const auto paletteVersion = style::PaletteVersion();
+	auto &entry = _entries[view];
+	if (entry.image.size() != size
+		|| entry.st != context.st.get()
+		|| entry.selection != context.selection
+		|| entry.paletteVersion != paletteVersion) {
+		_bytes -= ImageBytes(entry.image);
+		render(&entry, view, context);
+		_bytes += ImageBytes(entry.image);
+	}
+	entry.lastUsed = ++_lastUsed;
+	p.drawImage(0, 0, entry.image);
+	if (_bytes > kBytesLimit) {
+		evict();
+	}
+	return true;
+}
+
+void ScrollPaintCache::render(
+		not_null<Entry*> entry,
+		not_null<const Element*> view,
+		const Ui::ChatPaintContext &context) {
+	const auto ratio = style::DevicePixelRatio();
+	entry->image = QImage(
+		QSize(view->width(), view->height()) * ratio,
+		QImage::Format_ARGB32_Premultiplied);
+	entry->image.setDevicePixelRatio(ratio);
+	entry->image.fill(Qt::transparent);
+	entry->st = context.st.get();
+	entry->selection = context.selection;
+	entry->paletteVersion = style::PaletteVersion();
+
+	auto q = Painter(&entry->image);
+	auto full = context;
+	full.clip = QRect(0, 0, view->width(), view->height());
+	view->draw(q, full);
+}
+
+void ScrollPaintCache::invalidate(not_null<const Element*> view) {
+	const auto i = _entries.find(view);
+	if (i != end(_entries)) {
+		_bytes -= ImageBytes(i->second.image);
+		_entries.erase(i);
+	}
+}
+
+void ScrollPaintCache::clear() {
+	_entries.clear();
+	_bytes = 0;
+}
+
+void ScrollPaintCache::evict() {
+	auto used = std::vector<uint64>();
+	used.reserve(_entries.size());
+	for (const auto &[view, entry] : _entries) {
+		used.push_back(entry.lastUsed);
+	}
+
+	// Drop the least recently painted half.
+	const auto border = used.begin() + (used.size() / 2);
+	ranges::nth_element(used, border);
+	const auto till = *border;
+	for (auto i = begin(_entries); i != end(_entries);) {
+		if (i->second.lastUsed < till) {
+			_bytes -= ImageBytes(i->second.image);
+			i = _entries.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+} // namespace HistoryView
@@ -0,0 +1,62 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Ui {
+struct ChatPaintContext;
+} // namespace Ui
+
+namespace HistoryView {
+
+class Element;
+
+extern const char kOptionCacheMessagesWhileScrolling[];
+
+// While the history is scrolled item repaints are skipped anyway, so
+// static elements are rendered to images once and blitted on each step.
+// The cache should be cleared as soon as the scrolling stops.
+class ScrollPaintCache final {
+public:
+	[[nodiscard]] static bool Enabled();
+
+	// Returns false if the element should be painted directly.
+	bool paint(
+		QPainter &p,
+		not_null<const Element*> view,
+		const Ui::ChatPaintContext &context);
+
+	void invalidate(not_null<const Element*> view);
+	void clear();
+
+private:
+	struct Entry {
+		QImage image;
+		const void *st = nullptr;
+		TextSelection selection;
+		int paletteVersion = 0;
+		uint64 lastUsed = 0;
+	};
+
+	[[nodiscard]] static bool Cacheable(
+		not_null<const Element*> view,
+		const Ui::ChatPaintContext &context);
+	[[nodiscard]] static int64 ImageBytes(const QImage &image);
+
+	void render(
+		not_null<Entry*> entry,
+		not_null<const Element*> view,
+		const Ui::ChatPaintContext &context);
+	void evict();
+
+	base::flat_map<not_null<const Element*>, Entry> _entries;
+	int64 _bytes = 0;
+	uint64 _lastUsed = 0;
+
+};
+
+} // namespace HistoryView
@@ -15,6 +15,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "main/main_session_settings.h"
 #include "media/audio/media_audio.h"
 #include "media/clip/media_clip_reader.h"
+#include "media/media_animation_budget.h"
 #include "media/player/media_player_instance.h"
 #include "media/streaming/media_streaming_instance.h"
 #include "media/streaming/media_streaming_player.h"
@@ -532,7 +533,8 @@ void Gif::draw(Painter &p, const PaintContext &context) const {
 
 			const auto frame = streamed->frameWithInfo(request);
 			p.drawImage(rthumb, frame.image);
-			if (!paused) {
+			if (!paused
+				&& (activeOwnPlaying || allowNextFrame(context, rthumb))) {
 				streamed->markFrameShown();
 			}
 		}
@@ -848,6 +850,17 @@ void Gif::paintTranscribe(
 		context);
 }
 
+bool Gif::allowNextFrame(
+		const PaintContext &context,
+		QRect geometry) const {
+	return Core::App().animationBudget().allowNextFrame(
+		this,
+		geometry,
+		context.viewport,
+		context.now,
+		crl::guard(this, [=] { repaint(); }));
+}
+
 void Gif::drawSpoilerTag(
 		Painter &p,
 		QRect rthumb,
@@ -1344,7 +1357,8 @@ void Gif::drawGrouped(
 				activeOwnPlaying->frozenStatusText = QString();
 			}
 			p.drawImage(geometry, streamed->frame(request));
-			if (!context.paused) {
+			if (!context.paused
+				&& (activeOwnPlaying || allowNextFrame(context, geometry))) {
 				streamed->markFrameShown();
 			}
 		}
@@ -192,6 +192,9 @@ private:
 	[[nodiscard]] QSize sizeForAspectRatio() const;
 
 	void validateRoundingMask(QSize size) const;
+	[[nodiscard]] bool allowNextFrame(
+		const PaintContext &context,
+		QRect geometry) const;
 
 	[[nodiscard]] bool downloadInCorner() const;
 	void drawCornerStatus(
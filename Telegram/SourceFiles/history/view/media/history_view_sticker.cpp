@@ -25,6 +25,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/application.h"
 #include "core/core_settings.h"
 #include "core/click_handler_types.h"
+#include "media/media_animation_budget.h"
 #include "window/window_session_controller.h"
 #include "data/data_session.h"
 #include "data/data_document.h"
@@ -329,6 +330,7 @@ void Sticker::paintAnimationFrame(
 		|| (!lastDiceFrame && (_frameIndex != 0 || !_oncePlayed));
 	if (!paused
 		&& switchToNext
+		&& allowNextFrame(context, r)
 		&& _player->markFrameShown()
 		&& playOnce
 		&& !_oncePlayed) {
@@ -338,6 +340,17 @@ void Sticker::paintAnimationFrame(
 	checkPremiumEffectStart();
 }
 
+bool Sticker::allowNextFrame(
+		const PaintContext &context,
+		const QRect &r) {
+	return Core::App().animationBudget().allowNextFrame(
+		this,
+		r,
+		context.viewport,
+		context.now,
+		crl::guard(this, [=] { _parent->repaint(); }));
+}
+
 bool Sticker::paintPixmap(
 		Painter &p,
 		const PaintContext &context,
@@ -105,6 +105,9 @@ private:
 		Painter &p,
 		const PaintContext &context,
 		const QRect &r);
+	[[nodiscard]] bool allowNextFrame(
+		const PaintContext &context,
+		const QRect &r);
 	bool paintPixmap(Painter &p, const PaintContext &context, const QRect &r);
 	void paintPath(Painter &p, const PaintContext &context, const QRect &r);
 	[[nodiscard]] QPixmap paintedPixmap(const PaintContext &context) const;
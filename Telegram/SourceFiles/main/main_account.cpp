@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "base/platform/base_platform_info.h"
 #include "core/application.h"
+#include "core/tracing.h"
 #include "storage/storage_account.h"
 #include "storage/storage_domain.h" // Storage::StartResult.
 #include "storage/serialize_common.h"
@@ -45,6 +46,7 @@ constexpr auto kWideIdsTag = ~uint64(0);
 
 Account::Account(not_null<Domain*> domain, const QString &dataName, int index)
 : _domain(domain)
+, _index(index)
 , _local(std::make_unique<Storage::Account>(
 	this,
 	ComposeDataString(dataName, index))) {
@@ -187,9 +189,15 @@ void Account::createSession(
 	Expects(_session == nullptr);
 	Expects(_sessionValue.current() == nullptr);
 
-	_session = std::make_unique<Session>(this, user, std::move(settings));
-	if (!serialized.isEmpty()) {
-		local().readSelf(_session.get(), serialized, streamVersion);
+	{
+		const auto span = Tracing::Span("Main::Session", _index);
+		_session = std::make_unique<Session>(
+			this,
+			user,
+			std::move(settings));
+		if (!serialized.isEmpty()) {
+			local().readSelf(_session.get(), serialized, streamVersion);
+		}
 	}
 	_sessionValue = _session.get();
 
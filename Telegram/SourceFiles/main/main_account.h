@@ -40,6 +40,11 @@ public:
 
 	[[nodiscard]] Storage::Domain &domainLocal() const;
 
+	// Index of the account data folder, stays the same between launches.
+	[[nodiscard]] int index() const {
+		return _index;
+	}
+
 	[[nodiscard]] Storage::StartResult legacyStart(
 		const QByteArray &passcode);
 	[[nodiscard]] std::unique_ptr<MTP::Config> prepareToStart(
@@ -142,6 +147,7 @@ private:
 	void destroySession(DestroyReason reason);
 
 	const not_null<Domain*> _domain;
+	const int _index = 0;
 	const std::unique_ptr<Storage::Account> _local;
 
 	std::unique_ptr<MTP::Instance> _mtp;
@@ -38,6 +38,7 @@ class TopPeers;
 class Factchecks;
 class LocationPickers;
 class Credits;
+class MemoryManager;
 } // namespace Data
 
 namespace HistoryView::Reactions {
@@ -139,6 +140,9 @@ public:
 	[[nodiscard]] Data::Credits &credits() const {
 		return *_credits;
 	}
+	[[nodiscard]] Data::MemoryManager &memoryManager() const {
+		return *_memoryManager;
+	}
 	[[nodiscard]] Api::Updates &updates() const {
 		return *_updates;
 	}
@@ -270,6 +274,7 @@ private:
 	const std::unique_ptr<Data::Factchecks> _factchecks;
 	const std::unique_ptr<Data::LocationPickers> _locationPickers;
 	const std::unique_ptr<Data::Credits> _credits;
+	const std::unique_ptr<Data::MemoryManager> _memoryManager;
 
 	using ReactionIconFactory = HistoryView::Reactions::CachedIconFactory;
 	const std::unique_ptr<ReactionIconFactory> _cachedReactionIconFactory;
@@ -0,0 +1,95 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "media/media_animation_budget.h"
+
+namespace Media {
+namespace {
+
+constexpr auto kTickDuration = crl::time(16);
+
+// Budget is counted in units of 128x128 logical pixels on screen.
+constexpr auto kUnitArea = 128 * 128;
+constexpr auto kBudget = 64;
+constexpr auto kReducedBudget = 16;
+
+// Players showing less than this part of the viewport area or less than
+// half of themselves advance on every second tick only.
+constexpr auto kSmallPartOfViewport = 48;
+
+} // namespace
+
+AnimationBudget::AnimationBudget()
+: _retryTimer([=] { retryDeferred(); }) {
+}
+
+AnimationBudget::~AnimationBudget() = default;
+
+bool AnimationBudget::allowNextFrame(
+		not_null<const void*> player,
+		QRect geometry,
+		QRect viewport,
+		crl::time now,
+		Fn<void()> retry) {
+	if (viewport.isEmpty()) {
+		return true;
+	}
+	const auto visible = geometry.intersected(viewport);
+	if (visible.isEmpty()) {
+		// The player will be repainted when it is scrolled into view.
+		return false;
+	}
+	if (now - _tickStarted >= kTickDuration) {
+		startTick(now);
+	}
+	const auto area = visible.width() * visible.height();
+	const auto small = (area * kSmallPartOfViewport
+			< viewport.width() * viewport.height())
+		|| (area * 2 < geometry.width() * geometry.height());
+	const auto starving = _starvingPlayers.contains(player);
+	if (!starving) {
+		const auto budget = _reduced ? kReducedBudget : kBudget;
+		if ((small && (_tick % 2)) || _spent >= budget) {
+			defer(player, std::move(retry));
+			return false;
+		}
+	}
+	_spent += std::max(area / kUnitArea, 1);
+	return true;
+}
+
+void AnimationBudget::setReduced(bool reduced) {
+	_reduced = reduced;
+}
+
+void AnimationBudget::startTick(crl::time now) {
+	_tickStarted = now;
+	++_tick;
+	_spent = 0;
+	_starvingPlayers = base::take(_deferredPlayers);
+}
+
+void AnimationBudget::defer(
+		not_null<const void*> player,
+		Fn<void()> retry) {
+	if (!_deferredPlayers.emplace(player).second) {
+		return;
+	}
+	_retries.push_back(std::move(retry));
+	if (!_retryTimer.isActive()) {
+		const auto left = _tickStarted + kTickDuration - crl::now();
+		_retryTimer.callOnce(std::max(left, crl::time(1)));
+	}
+}
+
+void AnimationBudget::retryDeferred() {
+	for (const auto &retry : base::take(_retries)) {
+		retry();
+	}
+}
+
+} // namespace Media
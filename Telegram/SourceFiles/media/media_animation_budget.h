@@ -0,0 +1,53 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/timer.h"
+
+namespace Media {
+
+// Shares the frame work of animations visible in chats between them.
+//
+// Each frame tick has a budget measured in on-screen area. Players ask
+// the budget before switching to their next frame. Small or mostly
+// hidden players advance only on every second tick, players outside of
+// the viewport don't advance at all. A player deferred in one tick is
+// allowed first in the next one, so nobody stalls completely.
+class AnimationBudget final {
+public:
+	AnimationBudget();
+	~AnimationBudget();
+
+	// If false is returned the current frame should stay on screen and
+	// retry() will be called when the next tick starts.
+	[[nodiscard]] bool allowNextFrame(
+		not_null<const void*> player,
+		QRect geometry,
+		QRect viewport,
+		crl::time now,
+		Fn<void()> retry);
+
+	void setReduced(bool reduced);
+
+private:
+	void startTick(crl::time now);
+	void defer(not_null<const void*> player, Fn<void()> retry);
+	void retryDeferred();
+
+	base::flat_set<not_null<const void*>> _deferredPlayers;
+	base::flat_set<not_null<const void*>> _starvingPlayers;
+	std::vector<Fn<void()>> _retries;
+	base::Timer _retryTimer;
+	crl::time _tickStarted = 0;
+	int _tick = 0;
+	int _spent = 0;
+	bool _reduced = false;
+
+};
+
+} // namespace Media
@@ -65,6 +65,14 @@ constexpr int GetDcIdShift(ShiftedDcId shiftedDcId) {
 	return shiftedDcId / kDcShift;
 }
 
+// Interactive requests go to the session right away, while prefetch and
+// bulk requests may be held back by the per-dc scheduler in Instance.
+enum class RequestPriority : uchar {
+	Interactive,
+	Prefetch,
+	Bulk,
+};
+
 } // namespace MTP
 
 enum {
@@ -0,0 +1,226 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/details/mtproto_gzip.h"
+
+#include <zlib.h>
+
+namespace MTP::details {
+namespace {
+
+// Don't try to compress requests smaller than this size.
+constexpr auto kMinSizeToPack = 2048;
+
+// Compress this amount of bytes first to skip incompressible content,
+// like already compressed media or encrypted payloads.
+constexpr auto kProbeSize = 4096;
+
+// Send packed only if it saves at least this part of the request.
+constexpr auto kMinSavedPercent = 10;
+
+// Don't trust the declared unpacked length above this size.
+constexpr auto kMaxUnpackedSize = 64 * 1024 * 1024;
+
+// Reads serialized TL bytes in place without copying them.
+[[nodiscard]] bytes::const_span ReadBytes(
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	const auto available = (end - from) * sizeof(mtpPrime);
+	if (available < 4) {
+		return {};
+	}
+	const auto data = reinterpret_cast<const uchar*>(from);
+	const auto small = (data[0] != 254);
+	const auto length = small
+		? size_t(data[0])
+		: (size_t(data[1]) | (size_t(data[2]) << 8) | (size_t(data[3]) << 16));
+	const auto skip = small ? 1 : 4;
+	if (skip + length > available) {
+		return {};
+	}
+	return bytes::make_span(data + skip, length);
+}
+
+// The last four bytes of a gzip stream hold the unpacked length.
+[[nodiscard]] int DeclaredSize(bytes::const_span packed) {
+	if (packed.size() < 18) {
+		return 0;
+	}
+	const auto tail = reinterpret_cast<const uchar*>(
+		packed.data() + packed.size() - 4);
+	const auto result = uint32(tail[0])
+		| (uint32(tail[1]) << 8)
+		| (uint32(tail[2]) << 16)
+		| (uint32(tail[3]) << 24);
+	return (result > 0 && result <= kMaxUnpackedSize && !(result & 0x03))
+		? int(result)
+		: 0;
+}
+
+[[nodiscard]] bool SkipByType(mtpTypeId type) {
+	switch (type) {
+	case mtpc_upload_saveFilePart:
+	case mtpc_upload_saveBigFilePart:
+	case mtpc_gzip_packed:
+		return true;
+	}
+	return false;
+}
+
+[[nodiscard]] QByteArray Compress(bytes::const_span data, int level) {
+	auto stream = z_stream();
+	stream.zalloc = nullptr;
+	stream.zfree = nullptr;
+	stream.opaque = nullptr;
+	const auto res = deflateInit2(
+		&stream,
+		level,
+		Z_DEFLATED,
+		16 + MAX_WBITS,
+		8,
+		Z_DEFAULT_STRATEGY);
+	if (res != Z_OK) {
+		LOG(("MTP Error: could not init zlib deflate stream, code: %1"
+			).arg(res));
+		return QByteArray();
+	}
+	auto result = QByteArray();
+	result.resize(int(deflateBound(&stream, uLong(data.size()))));
+	stream.next_in = reinterpret_cast<Bytef*>(
+		const_cast<std::byte*>(data.data()));
+	stream.avail_in = uInt(data.size());
+	stream.next_out = reinterpret_cast<Bytef*>(result.data());
+	stream.avail_out = uInt(result.size());
+	const auto finished = (deflate(&stream, Z_FINISH) == Z_STREAM_END);
+	result.resize(result.size() - int(stream.avail_out));
+	deflateEnd(&stream);
+	return finished ? result : QByteArray();
+}
+
+[[nodiscard]] bool Compressible(bytes::const_span body) {
+	if (body.size() <= 2 * kProbeSize) {
+		return true;
+	}
+	const auto probe = Compress(body.subspan(0, kProbeSize), Z_BEST_SPEED);
+	return !probe.isEmpty()
+		&& (probe.size() * 100 <= kProbeSize * (100 - kMinSavedPercent));
+}
+
+} // namespace
+
+bool GzipUnpack(const mtpPrime *from, const mtpPrime *end, mtpBuffer &to) {
+	to.resize(0);
+
+	const auto packed = ReadBytes(from, end);
+	if (packed.empty()) {
+		LOG(("RPC Error: could not read gziped bytes."));
+		return false;
+	}
+	auto stream = z_stream();
+	stream.zalloc = nullptr;
+	stream.zfree = nullptr;
+	stream.opaque = nullptr;
+	stream.avail_in = 0;
+	stream.next_in = nullptr;
+	const auto res = inflateInit2(&stream, 16 + MAX_WBITS);
+	if (res != Z_OK) {
+		LOG(("RPC Error: could not init zlib stream, code: %1").arg(res));
+		return false;
+	}
+	stream.avail_in = uInt(packed.size());
+	stream.next_in = reinterpret_cast<Bytef*>(
+		const_cast<std::byte*>(packed.data()));
+
+	// If the declared size is right we inflate in a single pass,
+	// otherwise the buffer grows twice each time it is full.
+	// One more int is needed for inflate to reach the stream end.
+	const auto declared = DeclaredSize(packed);
+	auto chunk = declared
+		? (declared / int(sizeof(mtpPrime)) + 1)
+		: int(packed.size() / sizeof(mtpPrime)) + 1;
+	auto filled = 0;
+	while (true) {
+		to.resize(filled + chunk);
+		stream.avail_out = uInt(chunk * sizeof(mtpPrime));
+		stream.next_out = reinterpret_cast<Bytef*>(to.data() + filled);
+		const auto res = inflate(&stream, Z_NO_FLUSH);
+		if (res == Z_STREAM_END) {
+			break;
+		} else if (res != Z_OK && res != Z_BUF_ERROR) {
+			inflateEnd(&stream);
+			LOG(("RPC Error: could not unpack gziped data, code: %1"
+				).arg(res));
+			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(
+				packed.data(),
+				uint32(packed.size())).str()));
+			to.resize(0);
+			return false;
+		} else if (stream.avail_out) {
+			inflateEnd(&stream);
+			LOG(("RPC Error: gziped data is truncated."));
+			to.resize(0);
+			return false;
+		}
+		filled += chunk;
+		chunk = std::max(filled, 1024);
+		if (filled + chunk > kMaxUnpackedSize / int(sizeof(mtpPrime))) {
+			inflateEnd(&stream);
+			LOG(("RPC Error: gziped data is too large."));
+			to.resize(0);
+			return false;
+		}
+	}
+	inflateEnd(&stream);
+	if (stream.avail_out & 0x03) {
+		const auto badSize = uint32(to.size() * sizeof(mtpPrime))
+			- uint32(stream.avail_out);
+		LOG(("RPC Error: bad length of unpacked data %1").arg(badSize));
+		DEBUG_LOG(("RPC Error: bad unpacked data %1").arg(
+			Logs::mb(to.data(), badSize).str()));
+		to.resize(0);
+		return false;
+	}
+	to.resize(to.size() - (stream.avail_out >> 2));
+	if (to.isEmpty()) {
+		LOG(("RPC Error: bad length of unpacked data 0"));
+		return false;
+	}
+	return true;
+}
+
+SerializedRequest GzipPackRequest(const SerializedRequest &request) {
+	Expects(request->size() > SerializedRequest::kMessageBodyPosition);
+
+	const auto ints = (tl::count_length(request) >> 2);
+	const auto size = int(ints * sizeof(mtpPrime));
+	if (size < kMinSizeToPack
+		|| SkipByType((*request)[SerializedRequest::kMessageBodyPosition])) {
+		return SerializedRequest();
+	}
+	const auto body = bytes::make_span(*request).subspan(
+		SerializedRequest::kMessageBodyPosition * sizeof(mtpPrime),
+		size);
+	if (!Compressible(body)) {
+		return SerializedRequest();
+	}
+	const auto packed = MTP_bytes(Compress(body, Z_DEFAULT_COMPRESSION));
+	const auto packedInts = 1 + (tl::count_length(packed) >> 2);
+	if (packed.v.isEmpty()
+		|| packedInts * 100 > ints * (100 - kMinSavedPercent)) {
+		return SerializedRequest();
+	}
+	auto result = SerializedRequest::Prepare(packedInts);
+	result->push_back(mtpc_gzip_packed);
+	packed.write<mtpBuffer>(*result);
+	result->requestId = request->requestId;
+	result->priority = request->priority;
+	result->needsLayer = request->needsLayer;
+	result->forceSendInContainer = request->forceSendInContainer;
+	return result;
+}
+
+} // namespace MTP::details
@@ -0,0 +1,27 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/details/mtproto_serialized_request.h"
+
+namespace MTP::details {
+
+// Wraps the request body in gzip_packed if it is large enough and the
+// compression saves a noticeable amount of bytes, returns null otherwise.
+[[nodiscard]] SerializedRequest GzipPackRequest(
+	const SerializedRequest &request);
+
+// Inflates gzip_packed bytes (without the constructor id) into the buffer.
+// The buffer is sized once from the length declared in the gzip trailer
+// and its capacity is reused, so callers may keep it between calls.
+[[nodiscard]] bool GzipUnpack(
+	const mtpPrime *from,
+	const mtpPrime *end,
+	mtpBuffer &to);
+
+} // namespace MTP::details
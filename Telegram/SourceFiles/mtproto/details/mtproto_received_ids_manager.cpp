@@ -9,47 +9,116 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 namespace MTP::details {
 
+ReceivedIdsManager::ReceivedIdsManager() {
+	_table.fill(-1);
+}
+
+int ReceivedIdsManager::Hash(mtpMsgId msgId) {
+	return int((msgId * 0x9E3779B97F4A7C15ULL) >> (64 - kTableBits));
+}
+
+int ReceivedIdsManager::findSlot(mtpMsgId msgId) const {
+	for (auto slot = Hash(msgId);; slot = (slot + 1) & kTableMask) {
+		const auto position = _table[slot];
+		if (position < 0) {
+			return -1;
+		} else if (_entries[position].msgId == msgId) {
+			return slot;
+		}
+	}
+}
+
+bool ReceivedIdsManager::heapGreater(int16 a, int16 b) const {
+	return _entries[a].msgId > _entries[b].msgId;
+}
+
+void ReceivedIdsManager::eraseSlot(int slot) {
+	// Shift the following entries back, so that probing never stops
+	// on a hole before reaching an entry that is still in the table.
+	auto hole = slot;
+	for (auto next = (hole + 1) & kTableMask
+		; _table[next] >= 0
+		; next = (next + 1) & kTableMask) {
+		const auto ideal = Hash(_entries[_table[next]].msgId);
+		if (((next - ideal) & kTableMask) >= ((next - hole) & kTableMask)) {
+			_table[hole] = _table[next];
+			hole = next;
+		}
+	}
+	_table[hole] = -1;
+}
+
+int16 ReceivedIdsManager::evictMinimum() {
+	Expects(_count > 0);
+
+	const auto from = begin(_heap);
+	std::pop_heap(from, from + _count, [&](int16 a, int16 b) {
+		return heapGreater(a, b);
+	});
+	const auto position = _heap[--_count];
+	const auto slot = findSlot(_entries[position].msgId);
+	Assert(slot >= 0);
+	eraseSlot(slot);
+	return position;
+}
+
 ReceivedIdsManager::Result ReceivedIdsManager::registerMsgId(
 		mtpMsgId msgId,
 		bool needAck) {
-	const auto i = _idsNeedAck.find(msgId);
-	if (i != _idsNeedAck.end()) {
+	if (findSlot(msgId) >= 0) {
 		MTP_LOG(-1, ("No need to handle - %1 already is in map").arg(msgId));
 		return Result::Duplicate;
-	} else if (_idsNeedAck.size() < kIdsBufferSize || msgId > min()) {
-		_idsNeedAck.emplace(msgId, needAck);
-		return Result::Success;
+	} else if (_count == kIdsBufferSize && msgId <= min()) {
+		MTP_LOG(-1, ("Reset on too old - %1 < min = %2").arg(msgId).arg(min()));
+		return Result::TooOld;
+	}
+
+	// Positions are dense while the pool is not full,
+	// after that each new entry takes the place of the evicted one.
+	const auto position = (_count == kIdsBufferSize)
+		? evictMinimum()
+		: int16(_count);
+	_entries[position] = Entry{ .msgId = msgId, .needAck = needAck };
+
+	auto slot = Hash(msgId);
+	while (_table[slot] >= 0) {
+		slot = (slot + 1) & kTableMask;
 	}
-	MTP_LOG(-1, ("Reset on too old - %1 < min = %2").arg(msgId).arg(min()));
-	return Result::TooOld;
+	_table[slot] = position;
+
+	const auto from = begin(_heap);
+	_heap[_count++] = position;
+	std::push_heap(from, from + _count, [&](int16 a, int16 b) {
+		return heapGreater(a, b);
+	});
+
+	// The evicted minimum is never the maximum, it can't decrease.
+	_max = std::max(_max, msgId);
+	return Result::Success;
 }
 
 mtpMsgId ReceivedIdsManager::min() const {
-	return _idsNeedAck.empty() ? 0 : _idsNeedAck.begin()->first;
+	return _count ? _entries[_heap.front()].msgId : 0;
 }
 
 mtpMsgId ReceivedIdsManager::max() const {
-	auto end = _idsNeedAck.end();
-	return _idsNeedAck.empty() ? 0 : (--end)->first;
+	return _count ? _max : 0;
 }
 
 ReceivedIdsManager::State ReceivedIdsManager::lookup(mtpMsgId msgId) const {
-	auto i = _idsNeedAck.find(msgId);
-	if (i == _idsNeedAck.end()) {
+	const auto slot = findSlot(msgId);
+	if (slot < 0) {
 		return State::NotFound;
 	}
-	return i->second ? State::NeedsAck : State::NoAckNeeded;
-}
-
-void ReceivedIdsManager::shrink() {
-	auto size = _idsNeedAck.size();
-	while (size-- > kIdsBufferSize) {
-		_idsNeedAck.erase(_idsNeedAck.begin());
-	}
+	return _entries[_table[slot]].needAck
+		? State::NeedsAck
+		: State::NoAckNeeded;
 }
 
 void ReceivedIdsManager::clear() {
-	_idsNeedAck.clear();
+	_table.fill(-1);
+	_max = 0;
+	_count = 0;
 }
 
 } // namespace MTP::details
@@ -7,13 +7,14 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #pragma once
 
-#include "base/flat_map.h"
-
 namespace MTP::details {
 
 // Received msgIds and wereAcked msgIds count stored.
 inline constexpr auto kIdsBufferSize = 400;
 
+// Keeps kIdsBufferSize largest received msgIds in a fixed pool with an
+// open addressing index for O(1) lookup and a binary heap by msgId, so
+// that the minimal msgId is evicted first, like in a sorted set.
 class ReceivedIdsManager final {
 public:
 	enum class State {
@@ -27,16 +28,39 @@ public:
 		TooOld,
 	};
 
+	ReceivedIdsManager();
+
 	[[nodiscard]] Result registerMsgId(mtpMsgId msgId, bool needAck);
 	[[nodiscard]] mtpMsgId min() const;
 	[[nodiscard]] mtpMsgId max() const;
 	[[nodiscard]] State lookup(mtpMsgId msgId) const;
 
-	void shrink();
 	void clear();
 
 private:
-	base::flat_map<mtpMsgId, bool> _idsNeedAck;
+	static constexpr auto kTableBits = 10;
+	static constexpr auto kTableSize = (1 << kTableBits);
+	static constexpr auto kTableMask = kTableSize - 1;
+	static_assert(kTableSize >= 2 * kIdsBufferSize);
+
+	struct Entry {
+		mtpMsgId msgId = 0;
+		bool needAck = false;
+	};
+
+	[[nodiscard]] static int Hash(mtpMsgId msgId);
+	[[nodiscard]] int findSlot(mtpMsgId msgId) const;
+	[[nodiscard]] bool heapGreater(int16 a, int16 b) const;
+	void eraseSlot(int slot);
+	[[nodiscard]] int16 evictMinimum();
+
+	std::array<Entry, kIdsBufferSize> _entries;
+	std::array<int16, kTableSize> _table = {};
+
+	// Positions in _entries, the one with the minimal msgId first.
+	std::array<int16, kIdsBufferSize> _heap = {};
+	mtpMsgId _max = 0;
+	int _count = 0;
 
 };
 
@@ -0,0 +1,206 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/details/mtproto_request_scheduler.h"
+
+namespace MTP::details {
+namespace {
+
+constexpr auto kPrefetchBurst = 16.;
+constexpr auto kPrefetchPerSecond = 8.;
+constexpr auto kBulkBurst = 8.;
+constexpr auto kBulkPerSecond = 16.;
+constexpr auto kInteractiveQuietTime = crl::time(300);
+
+[[nodiscard]] double Burst(RequestPriority priority) {
+	return (priority == RequestPriority::Bulk)
+		? kBulkBurst
+		: kPrefetchBurst;
+}
+
+[[nodiscard]] double PerSecond(RequestPriority priority) {
+	return (priority == RequestPriority::Bulk)
+		? kBulkPerSecond
+		: kPrefetchPerSecond;
+}
+
+} // namespace
+
+auto RequestScheduler::dc(DcId dcId, crl::time now) -> Dc & {
+	auto i = _dcs.find(dcId);
+	if (i == end(_dcs)) {
+		i = _dcs.emplace(dcId, Dc{
+			.prefetch = { .bucket = { kPrefetchBurst, now } },
+			.bulk = { .bucket = { kBulkBurst, now } },
+		}).first;
+	}
+	return i->second;
+}
+
+void RequestScheduler::Refill(
+		Bucket &bucket,
+		RequestPriority priority,
+		crl::time now) {
+	if (now <= bucket.refilled) {
+		return;
+	}
+	const auto add = (now - bucket.refilled) * PerSecond(priority) / 1000.;
+	bucket.tokens = std::min(bucket.tokens + add, Burst(priority));
+	bucket.refilled = now;
+}
+
+crl::time RequestScheduler::TokenIn(
+		const Bucket &bucket,
+		RequestPriority priority,
+		crl::time now) {
+	if (bucket.tokens >= 1.) {
+		return 0;
+	}
+	const auto missing = 1. - bucket.tokens;
+	const auto ready = bucket.refilled
+		+ crl::time(std::ceil(missing * 1000. / PerSecond(priority)));
+	return std::max(ready - now, crl::time(0));
+}
+
+bool RequestScheduler::ready(
+		const Dc &data,
+		RequestPriority priority,
+		crl::time now) const {
+	if (now < data.floodUntil) {
+		return false;
+	} else if (priority == RequestPriority::Bulk) {
+		return (now >= data.interactiveUntil)
+			&& (data.bulk.bucket.tokens >= 1.);
+	}
+	return (data.prefetch.bucket.tokens >= 1.);
+}
+
+bool RequestScheduler::admit(
+		mtpRequestId requestId,
+		DcId dcId,
+		RequestPriority priority,
+		crl::time msCanWait,
+		crl::time now) {
+	auto &data = dc(dcId, now);
+	if (priority == RequestPriority::Interactive) {
+		data.interactiveUntil = now + kInteractiveQuietTime;
+		return true;
+	}
+	auto &queue = (priority == RequestPriority::Bulk)
+		? data.bulk
+		: data.prefetch;
+	Refill(queue.bucket, priority, now);
+	if (queue.requests.empty() && ready(data, priority, now)) {
+		queue.bucket.tokens -= 1.;
+		return true;
+	}
+	queue.requests.push_back({
+		.requestId = requestId,
+		.msCanWait = msCanWait,
+	});
+	_queued.emplace(requestId, dcId);
+	return false;
+}
+
+auto RequestScheduler::find(mtpRequestId requestId)
+-> std::pair<Queue*, std::deque<Ready>::iterator> {
+	const auto i = _queued.find(requestId);
+	const auto j = (i != end(_queued)) ? _dcs.find(i->second) : end(_dcs);
+	if (j == end(_dcs)) {
+		return {};
+	}
+	for (const auto queue : { &j->second.prefetch, &j->second.bulk }) {
+		const auto k = ranges::find(
+			queue->requests,
+			requestId,
+			&Ready::requestId);
+		if (k != end(queue->requests)) {
+			return { queue, k };
+		}
+	}
+	return {};
+}
+
+bool RequestScheduler::enqueueAfter(
+		mtpRequestId requestId,
+		mtpRequestId afterRequestId,
+		crl::time msCanWait) {
+	const auto [queue, i] = find(afterRequestId);
+	if (!queue) {
+		return false;
+	}
+	// Keep the dependent requests in the order they were sent.
+	auto position = i + 1;
+	while (position != end(queue->requests)
+		&& position->after == afterRequestId) {
+		++position;
+	}
+	queue->requests.insert(position, {
+		.requestId = requestId,
+		.msCanWait = msCanWait,
+		.after = afterRequestId,
+	});
+	_queued.emplace(requestId, _queued.find(afterRequestId)->second);
+	return true;
+}
+
+void RequestScheduler::remove(mtpRequestId requestId) {
+	const auto [queue, i] = find(requestId);
+	if (queue) {
+		queue->requests.erase(i);
+	}
+	_queued.remove(requestId);
+}
+
+void RequestScheduler::floodWait(DcId dcId, crl::time until) {
+	auto &data = dc(dcId, crl::now());
+	data.floodUntil = std::max(data.floodUntil, until);
+}
+
+auto RequestScheduler::takeReady(crl::time now) -> std::vector<Ready> {
+	auto result = std::vector<Ready>();
+	for (auto &[dcId, data] : _dcs) {
+		const auto take = [&](Queue &queue, RequestPriority priority) {
+			Refill(queue.bucket, priority, now);
+			while (!queue.requests.empty() && ready(data, priority, now)) {
+				queue.bucket.tokens -= 1.;
+				const auto ready = queue.requests.front();
+				queue.requests.pop_front();
+				_queued.remove(ready.requestId);
+				result.push_back(ready);
+			}
+		};
+		take(data.prefetch, RequestPriority::Prefetch);
+		take(data.bulk, RequestPriority::Bulk);
+	}
+	return result;
+}
+
+crl::time RequestScheduler::nextCheckIn(crl::time now) const {
+	auto result = crl::time(-1);
+	const auto accumulate = [&](crl::time delay) {
+		result = (result < 0) ? delay : std::min(result, delay);
+	};
+	for (const auto &[dcId, data] : _dcs) {
+		const auto flood = std::max(data.floodUntil - now, crl::time(0));
+		if (!data.prefetch.requests.empty()) {
+			accumulate(std::max(
+				flood,
+				TokenIn(data.prefetch.bucket, RequestPriority::Prefetch, now)));
+		}
+		if (!data.bulk.requests.empty()) {
+			accumulate(std::max({
+				flood,
+				data.interactiveUntil - now,
+				TokenIn(data.bulk.bucket, RequestPriority::Bulk, now),
+			}));
+		}
+	}
+	return (result < 0) ? result : std::max(result, crl::time(1));
+}
+
+} // namespace MTP::details
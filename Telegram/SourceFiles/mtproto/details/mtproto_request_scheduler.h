@@ -0,0 +1,93 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/core_types.h"
+#include "base/flat_map.h"
+
+#include <crl/crl_time.h>
+
+namespace MTP::details {
+
+// Decides when prefetch and bulk requests may be passed to the session.
+//
+// Each dc has a token bucket for every non-interactive priority. Bulk
+// requests additionally wait while interactive requests were sent to the
+// same dc recently and all background traffic waits out FLOOD_WAIT errors.
+//
+// Main thread only.
+class RequestScheduler final {
+public:
+	struct Ready {
+		mtpRequestId requestId = 0;
+		crl::time msCanWait = 0;
+		mtpRequestId after = 0;
+	};
+
+	// Returns true if the request can be sent right away,
+	// otherwise it is queued until takeReady() returns it.
+	[[nodiscard]] bool admit(
+		mtpRequestId requestId,
+		DcId dcId,
+		RequestPriority priority,
+		crl::time msCanWait,
+		crl::time now);
+
+	// If the request it must be sent after is still queued, queues this
+	// one right behind it and returns true, whatever its priority is.
+	[[nodiscard]] bool enqueueAfter(
+		mtpRequestId requestId,
+		mtpRequestId afterRequestId,
+		crl::time msCanWait);
+	void remove(mtpRequestId requestId);
+	void floodWait(DcId dcId, crl::time until);
+
+	[[nodiscard]] std::vector<Ready> takeReady(crl::time now);
+
+	// Returns the delay until the next queued request may be ready,
+	// or -1 if there are no queued requests.
+	[[nodiscard]] crl::time nextCheckIn(crl::time now) const;
+
+private:
+	struct Bucket {
+		double tokens = 0.;
+		crl::time refilled = 0;
+	};
+	struct Queue {
+		Bucket bucket;
+		std::deque<Ready> requests;
+	};
+	struct Dc {
+		Queue prefetch;
+		Queue bulk;
+		crl::time floodUntil = 0;
+		crl::time interactiveUntil = 0;
+	};
+
+	[[nodiscard]] Dc &dc(DcId dcId, crl::time now);
+	[[nodiscard]] std::pair<Queue*, std::deque<Ready>::iterator> find(
+		mtpRequestId requestId);
+	[[nodiscard]] bool ready(
+		const Dc &data,
+		RequestPriority priority,
+		crl::time now) const;
+	static void Refill(
+		Bucket &bucket,
+		RequestPriority priority,
+		crl::time now);
+	[[nodiscard]] static crl::time TokenIn(
+		const Bucket &bucket,
+		RequestPriority priority,
+		crl::time now);
+
+	base::flat_map<DcId, Dc> _dcs;
+	base::flat_map<mtpRequestId, DcId> _queued;
+
+};
+
+} // namespace MTP::details
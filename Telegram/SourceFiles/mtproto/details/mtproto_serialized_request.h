@@ -90,6 +90,7 @@ public:
 	SerializedRequest after;
 	crl::time lastSentTime = 0;
 	mtpRequestId requestId = 0;
+	RequestPriority priority = RequestPriority::Interactive;
 	bool needsLayer = false;
 	bool forceSendInContainer = false;
 
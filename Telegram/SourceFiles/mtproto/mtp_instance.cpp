@@ -8,6 +8,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtp_instance.h"
 
 #include "mtproto/details/mtproto_dcenter.h"
+#include "mtproto/details/mtproto_gzip.h"
+#include "mtproto/details/mtproto_request_scheduler.h"
 #include "mtproto/details/mtproto_rsa_public_key.h"
 #include "mtproto/special_config_request.h"
 #include "mtproto/session.h"
@@ -20,6 +22,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "main/main_account.h" // Account::configUpdated.
 #include "core/application.h"
 #include "core/core_settings.h"
+#include "core/tracing.h"
 #include "lang/lang_instance.h"
 #include "lang/lang_cloud_manager.h"
 #include "base/unixtime.h"
@@ -178,6 +181,8 @@ public:
 
 	void prepareToDestroy();
 
+	[[nodiscard]] int64 packedBytesSaved() const;
+
 	[[nodiscard]] rpl::lifetime &lifetime();
 
 private:
@@ -216,6 +221,9 @@ private:
 		mtpRequestId requestId, DcId newdc);
 
 	void checkDelayedRequests();
+	void sendScheduledRequests();
+	void checkScheduledRequestsIn(crl::time now);
+	void tryPackRequest(SerializedRequest &request, ShiftedDcId shiftedDcId);
 
 	const not_null<Instance*> _instance;
 	const Instance::Mode _mode = Instance::Mode::Normal;
@@ -278,6 +286,11 @@ private:
 
 	std::set<mtpRequestId> _badGuestDcRequests;
 
+	RequestScheduler _scheduler;
+	base::Timer _scheduledTimer;
+
+	int64 _packedBytesSaved = 0;
+
 	std::map<DcId, std::vector<mtpRequestId>> _authWaiters;
 
 	Fn<void(const Response&)> _updatesHandler;
@@ -380,6 +393,7 @@ void Instance::Private::start() {
 	}
 
 	_checkDelayedTimer.setCallback([this] { checkDelayedRequests(); });
+	_scheduledTimer.setCallback([this] { sendScheduledRequests(); });
 
 	Assert(!hasMainDcId() == isKeysDestroyer());
 	requestConfig();
@@ -917,6 +931,7 @@ void Instance::Private::configLoadDone(const MTPConfig &result) {
 
 	_configLoader.reset();
 	_lastConfigLoadedTime = crl::now();
+	Tracing::Instant("MTP config loaded", mainDcId());
 
 	const auto &data = result.c_config();
 	_config->apply(data);
@@ -1002,6 +1017,33 @@ void Instance::Private::checkDelayedRequests() {
 	}
 }
 
+void Instance::Private::sendScheduledRequests() {
+	const auto now = crl::now();
+	for (const auto &[requestId, msCanWait] : _scheduler.takeReady(now)) {
+		const auto shiftedDcId = queryRequestByDc(requestId);
+		if (!shiftedDcId) {
+			LOG(("MTP Error: could not find request dc for scheduled send, requestId %1").arg(requestId));
+			continue;
+		}
+		const auto request = getRequest(requestId);
+		if (!request) {
+			DEBUG_LOG(("MTP Error: could not find scheduled request %1").arg(requestId));
+			continue;
+		}
+		getSession(qAbs(*shiftedDcId))->sendPrepared(request, msCanWait);
+	}
+	checkScheduledRequestsIn(now);
+}
+
+void Instance::Private::checkScheduledRequestsIn(crl::time now) {
+	const auto delay = _scheduler.nextCheckIn(now);
+	if (delay >= 0
+		&& (!_scheduledTimer.isActive()
+			|| _scheduledTimer.remainingTime() > delay)) {
+		_scheduledTimer.callOnce(delay);
+	}
+}
+
 void Instance::Private::sendRequest(
 		mtpRequestId requestId,
 		SerializedRequest &&request,
@@ -1012,6 +1054,9 @@ void Instance::Private::sendRequest(
 		mtpRequestId afterRequestId) {
 	const auto session = getSession(shiftedDcId);
 
+	if (needsLayer) {
+		tryPackRequest(request, session->getDcWithShift());
+	}
 	request->requestId = requestId;
 	storeRequest(requestId, request, std::move(callbacks));
 
@@ -1039,9 +1084,47 @@ void Instance::Private::sendRequest(
 		}
 	}
 
+	if (request->after) {
+		// The session wraps it in invokeAfterMsg only if the dependency
+		// was already sent, so it can't overtake a queued dependency.
+		if (_scheduler.enqueueAfter(requestId, afterRequestId, msCanWait)) {
+			return;
+		}
+	} else if (!_scheduler.admit(
+			requestId,
+			BareDcId(realShiftedDcId),
+			request->priority,
+			msCanWait,
+			request->lastSentTime)) {
+		checkScheduledRequestsIn(request->lastSentTime);
+		return;
+	}
 	session->sendPrepared(request, msCanWait);
 }
 
+void Instance::Private::tryPackRequest(
+		SerializedRequest &request,
+		ShiftedDcId shiftedDcId) {
+	const auto shift = GetDcIdShift(shiftedDcId);
+	if (shift >= kBaseUploadDcShift
+		&& shift < kBaseUploadDcShift + kMaxMediaDcCount) {
+		return;
+	}
+	const auto was = request.messageSize();
+	if (auto packed = GzipPackRequest(request)) {
+		const auto now = packed.messageSize();
+		_packedBytesSaved += int64(was - now) * sizeof(mtpPrime);
+		DEBUG_LOG(("MTP Info: packed request from %1 to %2 bytes."
+			).arg(was * sizeof(mtpPrime)
+			).arg(now * sizeof(mtpPrime)));
+		request = std::move(packed);
+	}
+}
+
+int64 Instance::Private::packedBytesSaved() const {
+	return _packedBytesSaved;
+}
+
 void Instance::Private::registerRequest(
 		mtpRequestId requestId,
 		ShiftedDcId shiftedDcId) {
@@ -1053,6 +1136,7 @@ void Instance::Private::unregisterRequest(mtpRequestId requestId) {
 	DEBUG_LOG(("MTP Info: unregistering request %1.").arg(requestId));
 
 	_requestsDelays.erase(requestId);
+	_scheduler.remove(requestId);
 
 	{
 		QWriteLocker locker(&_requestMapLock);
@@ -1511,6 +1595,13 @@ bool Instance::Private::onErrorDefault(
 			secs = m3.captured(1).toInt();
 		}
 		auto sendAt = crl::now() + secs * 1000 + 10;
+		if (m1.hasMatch() || m2.hasMatch()) {
+			// Hold back background traffic to this dc while it is flooded.
+			if (const auto shiftedDcId = queryRequestByDc(requestId)) {
+				_scheduler.floodWait(BareDcId(qAbs(*shiftedDcId)), sendAt);
+				checkScheduledRequestsIn(crl::now());
+			}
+		}
 		auto it = _delayedRequests.begin(), e = _delayedRequests.end();
 		for (; it != e; ++it) {
 			if (it->first == requestId) {
@@ -2106,6 +2197,10 @@ void Instance::sendAnything(ShiftedDcId shiftedDcId, crl::time msCanWait) {
 	_private->getSession(shiftedDcId)->sendAnything(msCanWait);
 }
 
+int64 Instance::packedBytesSaved() const {
+	return _private->packedBytesSaved();
+}
+
 rpl::lifetime &Instance::lifetime() {
 	return _private->lifetime();
 }
@@ -154,7 +154,8 @@ public:
 			ShiftedDcId shiftedDcId = 0,
 			crl::time msCanWait = 0,
 			mtpRequestId afterRequestId = 0,
-			mtpRequestId overrideRequestId = 0) {
+			mtpRequestId overrideRequestId = 0,
+			RequestPriority priority = RequestPriority::Interactive) {
 		const auto requestId = overrideRequestId
 			? overrideRequestId
 			: details::GetNextRequestId();
@@ -164,7 +165,8 @@ public:
 			std::move(callbacks),
 			shiftedDcId,
 			msCanWait,
-			afterRequestId);
+			afterRequestId,
+			priority);
 		return requestId;
 	}
 
@@ -176,14 +178,16 @@ public:
 			ShiftedDcId shiftedDcId = 0,
 			crl::time msCanWait = 0,
 			mtpRequestId afterRequestId = 0,
-			mtpRequestId overrideRequestId = 0) {
+			mtpRequestId overrideRequestId = 0,
+			RequestPriority priority = RequestPriority::Interactive) {
 		return send(
 			request,
 			ResponseHandler{ std::move(onDone), std::move(onFail) },
 			shiftedDcId,
 			msCanWait,
 			afterRequestId,
-			overrideRequestId);
+			overrideRequestId,
+			priority);
 	}
 
 	template <typename Request>
@@ -208,8 +212,10 @@ public:
 			ResponseHandler &&callbacks,
 			ShiftedDcId shiftedDcId,
 			crl::time msCanWait,
-			mtpRequestId afterRequestId) {
+			mtpRequestId afterRequestId,
+			RequestPriority priority = RequestPriority::Interactive) {
 		const auto needsLayer = true;
+		request->priority = priority;
 		sendRequest(
 			requestId,
 			std::move(request),
@@ -220,6 +226,9 @@ public:
 			afterRequestId);
 	}
 
+	// Main thread.
+	[[nodiscard]] int64 packedBytesSaved() const;
+
 	[[nodiscard]] rpl::lifetime &lifetime();
 
 Q_SIGNALS:
@@ -107,11 +107,17 @@ void ConcurrentSender::RequestBuilder::setAfter(
 	_afterRequestId = requestId;
 }
 
+void ConcurrentSender::RequestBuilder::setPriority(
+		RequestPriority priority) noexcept {
+	_priority = priority;
+}
+
 mtpRequestId ConcurrentSender::RequestBuilder::send() {
 	const auto requestId = details::GetNextRequestId();
 	const auto dcId = _dcId;
 	const auto msCanWait = _canWait;
 	const auto afterRequestId = _afterRequestId;
+	const auto priority = _priority;
 
 	_sender->senderRequestRegister(requestId, std::move(_handlers));
 	_sender->with_instance([
@@ -129,7 +135,8 @@ mtpRequestId ConcurrentSender::RequestBuilder::send() {
 			ResponseHandler{ std::move(done), std::move(fail) },
 			dcId,
 			msCanWait,
-			afterRequestId);
+			afterRequestId,
+			priority);
 	});
 
 	return requestId;
@@ -68,6 +68,7 @@ class ConcurrentSender : public base::has_weak_ptr {
 		void setFailHandler(InvokeFullFail &&invoke) noexcept;
 		void setFailSkipPolicy(FailSkipPolicy policy) noexcept;
 		void setAfter(mtpRequestId requestId) noexcept;
+		void setPriority(RequestPriority priority) noexcept;
 
 	private:
 		not_null<ConcurrentSender*> _sender;
@@ -78,6 +79,7 @@ class ConcurrentSender : public base::has_weak_ptr {
 		Handlers _handlers;
 		FailSkipPolicy _failSkipPolicy = FailSkipPolicy::Simple;
 		mtpRequestId _afterRequestId = 0;
+		RequestPriority _priority = RequestPriority::Interactive;
 
 	};
 
@@ -128,6 +130,8 @@ public:
 		[[nodiscard]] SpecificRequestBuilder &handleAllErrors() noexcept;
 		[[nodiscard]] SpecificRequestBuilder &afterRequest(
 			mtpRequestId requestId) noexcept;
+		[[nodiscard]] SpecificRequestBuilder &priority(
+			RequestPriority priority) noexcept;
 
 	private:
 		SpecificRequestBuilder(
@@ -397,6 +401,14 @@ auto ConcurrentSender::SpecificRequestBuilder<Request>::afterRequest(
 	return *this;
 }
 
+template <typename Request>
+auto ConcurrentSender::SpecificRequestBuilder<Request>::priority(
+	RequestPriority priority
+) noexcept -> SpecificRequestBuilder & {
+	setPriority(priority);
+	return *this;
+}
+
 inline void ConcurrentSender::SentRequestWrap::cancel() {
 	_sender->senderRequestCancel(_requestId);
 }
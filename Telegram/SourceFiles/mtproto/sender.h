@@ -149,6 +149,9 @@ class Sender {
 		void setAfter(mtpRequestId requestId) noexcept {
 			_afterRequestId = requestId;
 		}
+		void setPriority(RequestPriority priority) noexcept {
+			_priority = priority;
+		}
 
 		[[nodiscard]] ShiftedDcId takeDcId() const noexcept {
 			return _dcId;
@@ -173,6 +176,9 @@ class Sender {
 		[[nodiscard]] mtpRequestId takeOverrideRequestId() const noexcept {
 			return _overrideRequestId;
 		}
+		[[nodiscard]] RequestPriority takePriority() const noexcept {
+			return _priority;
+		}
 
 		[[nodiscard]] not_null<Sender*> sender() const noexcept {
 			return _sender;
@@ -194,6 +200,7 @@ class Sender {
 		FailSkipPolicy _failSkipPolicy = FailSkipPolicy::Simple;
 		mtpRequestId _afterRequestId = 0;
 		mtpRequestId _overrideRequestId = 0;
+		RequestPriority _priority = RequestPriority::Interactive;
 
 	};
 
@@ -299,6 +306,10 @@ public:
 			setAfter(requestId);
 			return *this;
 		}
+		[[nodiscard]] SpecificRequestBuilder &priority(RequestPriority priority) noexcept {
+			setPriority(priority);
+			return *this;
+		}
 
 		mtpRequestId send() {
 			const auto id = sender()->_instance->send(
@@ -308,7 +319,8 @@ public:
 				takeDcId(),
 				takeCanWait(),
 				takeAfter(),
-				takeOverrideRequestId());
+				takeOverrideRequestId(),
+				takePriority());
 			registerRequest(id);
 			return id;
 		}
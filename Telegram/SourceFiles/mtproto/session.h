@@ -30,6 +30,9 @@ enum class TemporaryKeyType;
 enum class CreatingKeyType;
 
 struct SessionOptions {
+	static constexpr auto kDefaultSendCoalesceWindow = crl::time(20);
+	static constexpr auto kDefaultContainerTargetSize = 64 * 1024;
+
 	SessionOptions() = default;
 	SessionOptions(
 		const QString &systemLangCode,
@@ -50,6 +53,11 @@ struct SessionOptions {
 	bool useHttp = true;
 	bool useTcp = true;
 
+	// Non-interactive requests may wait up to sendCoalesceWindow for more
+	// requests, until containerTargetSize bytes are ready to be sent.
+	crl::time sendCoalesceWindow = kDefaultSendCoalesceWindow;
+	int containerTargetSize = kDefaultContainerTargetSize;
+
 };
 
 class Session;
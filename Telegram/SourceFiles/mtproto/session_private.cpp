@@ -10,11 +10,13 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/details/mtproto_bound_key_creator.h"
 #include "mtproto/details/mtproto_dcenter.h"
 #include "mtproto/details/mtproto_dump_to_text.h"
+#include "mtproto/details/mtproto_gzip.h"
 #include "mtproto/details/mtproto_rsa_public_key.h"
 #include "mtproto/session.h"
 #include "mtproto/mtproto_response.h"
 #include "mtproto/mtproto_dc_options.h"
 #include "mtproto/connection_abstract.h"
+#include "core/tracing.h"
 #include "base/random.h"
 #include "base/qthelp_url.h"
 #include "base/openssl_help.h"
@@ -22,7 +24,6 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/platform/base_platform_info.h"
 
 #include <ksandbox.h>
-#include <zlib.h>
 
 namespace MTP {
 namespace details {
@@ -60,7 +61,14 @@ constexpr auto kSendStateRequestWaiting = crl::time(1000);
 // How much time to wait for some more requests, when sending msg acks.
 constexpr auto kAckSendWaiting = 10 * crl::time(1000);
 
-constexpr auto kCutContainerOnSize = 16 * 1024;
+// Flush acks within the coalesce window if too many of them are pending.
+constexpr auto kAckFlushCount = 64;
+
+// Keep the buffer for unpacking gzip_packed messages up to this capacity.
+constexpr auto kMaxPooledUnpackedSize = 256 * 1024;
+
+// How often the container fill and writes rate are written to the log.
+constexpr auto kSendStatsPeriod = 60 * crl::time(1000);
 
 auto SyncTimeRequestDuration = kFastRequestDuration;
 
@@ -161,6 +169,7 @@ SessionPrivate::SessionPrivate(
 , _pingSender(thread, [=] { sendPingByTimer(); })
 , _checkSentRequestsTimer(thread, [=] { checkSentRequests(); })
 , _clearOldContainersTimer(thread, [=] { clearOldContainers(); })
+, _coalesceTimer(thread, [=] { tryToSend(); })
 , _sessionData(std::move(data)) {
 	Expects(_shiftedDcId != 0);
 
@@ -585,6 +594,13 @@ void SessionPrivate::tryToSend() {
 		&& _pingSendAt <= crl::now()) {
 		_pingIdToSend = base::RandomValue<mtpPingId>();
 	}
+	if (sendAll && !needsLayer && !_pingIdToSend && holdForCoalescing()) {
+		DEBUG_LOG(("MTP Info: dc %1 waiting for more requests to pack."
+			).arg(_shiftedDcId));
+		return;
+	}
+	_coalesceTimer.cancel();
+
 	const auto forceNewMsgId = sendAll && markSessionAsStarted();
 	if (forceNewMsgId && _keyCreator) {
 		_keyCreator->restartBinder();
@@ -718,9 +734,10 @@ void SessionPrivate::tryToSend() {
 		auto sendingFrom = begin(toSend);
 		auto sendingTill = end(toSend);
 		auto combinedLength = 0;
+		const auto targetLength = _options->containerTargetSize;
 		for (auto i = sendingFrom; i != sendingTill; ++i) {
-			combinedLength += i->second->size();
-			if (combinedLength >= kCutContainerOnSize) {
+			combinedLength += int(i->second.messageSize()) * kIntSize;
+			if (combinedLength >= targetLength) {
 				++i;
 				if (const auto skipping = int(sendingTill - i)) {
 					sendingTill = i;
@@ -973,7 +990,14 @@ void SessionPrivate::tryToSend() {
 			}
 		}
 	}
-	sendSecureRequest(std::move(toSendRequest), needAnyResponse);
+	const auto container = (toSendRequest->size()
+		> SerializedRequest::kMessageBodyPosition)
+		&& ((*toSendRequest)[SerializedRequest::kMessageBodyPosition]
+			== mtpc_msg_container);
+	const auto size = int(toSendRequest.messageSize()) * kIntSize;
+	if (sendSecureRequest(std::move(toSendRequest), needAnyResponse)) {
+		accumulateSendStats(size, container);
+	}
 	if (someSkipped) {
 		InvokeQueued(this, [=] {
 			tryToSend();
@@ -981,6 +1005,72 @@ void SessionPrivate::tryToSend() {
 	}
 }
 
+bool SessionPrivate::holdForCoalescing() {
+	const auto window = _options->sendCoalesceWindow;
+	if (window <= 0
+		|| !_resendRequestData.isEmpty()
+		|| !_stateRequestData.empty()) {
+		// Resend and state requests answer the server, don't delay them.
+		return false;
+	}
+	const auto now = crl::now();
+	auto oldest = now;
+	auto size = 0;
+	{
+		QReadLocker locker(_sessionData->toSendMutex());
+		for (const auto &[requestId, request] : _sessionData->toSendMap()) {
+			if (request->priority == RequestPriority::Interactive) {
+				return false;
+			}
+			size += int(request.messageSize()) * kIntSize;
+			oldest = std::min(oldest, request->lastSentTime);
+		}
+	}
+	if (!size) {
+		return false;
+	}
+
+	// Pending acks go in the same container.
+	size += int(_ackRequestData.size() * sizeof(mtpMsgId));
+	if (size >= _options->containerTargetSize) {
+		return false;
+	}
+	const auto wait = oldest + window - now;
+	if (wait <= 0) {
+		return false;
+	}
+	_coalesceTimer.callOnce(wait);
+	return true;
+}
+
+void SessionPrivate::accumulateSendStats(int size, bool container) {
+	const auto now = crl::now();
+	if (!_sendStats.since) {
+		_sendStats.since = now;
+	}
+	++_sendStats.writes;
+	if (container) {
+		++_sendStats.containers;
+		_sendStats.containersSize += size;
+	}
+	const auto passed = now - _sendStats.since;
+	if (passed < kSendStatsPeriod) {
+		return;
+	}
+	const auto stats = base::take(_sendStats);
+	const auto target = _options->containerTargetSize;
+	const auto fill = stats.containers
+		? (100. * stats.containersSize / (stats.containers * target))
+		: 0.;
+	DEBUG_LOG(("MTP Info: dc %1 sent %2 writes/s, "
+		"%3 containers with average fill %4% of %5 bytes."
+		).arg(_shiftedDcId
+		).arg(stats.writes * 1000. / passed, 0, 'f', 2
+		).arg(stats.containers
+		).arg(fill, 0, 'f', 1
+		).arg(target));
+}
+
 void SessionPrivate::retryByTimer() {
 	if (_retryTimeout < 3) {
 		++_retryTimeout;
@@ -1396,12 +1486,13 @@ void SessionPrivate::handleReceived() {
 		} else if (registered == ReceivedIdsManager::Result::TooOld) {
 			res = HandleResult::ResetSession;
 		}
-		_receivedMessageIds.shrink();
 
 		// send acks
 		if (const auto toAckSize = _ackRequestData.size()) {
 			DEBUG_LOG(("MTP Info: will send %1 acks, ids: %2").arg(toAckSize).arg(LogIdsVector(_ackRequestData)));
-			_sessionData->queueSendAnything(kAckSendWaiting);
+			_sessionData->queueSendAnything((toAckSize >= kAckFlushCount)
+				? _options->sendCoalesceWindow
+				: kAckSendWaiting);
 		}
 
 		auto lock = QReadLocker(_sessionData->haveReceivedMutex());
@@ -1447,11 +1538,23 @@ SessionPrivate::HandleResult SessionPrivate::handleOneReceived(
 
 	case mtpc_gzip_packed: {
 		DEBUG_LOG(("Message Info: gzip container"));
-		mtpBuffer response = ungzip(++from, end);
-		if (response.empty()) {
+
+		// Nested gzip_packed take their own buffer, the outer one
+		// is returned to the pool when it is not needed anymore.
+		auto response = base::take(_unpackedPool);
+		if (!GzipUnpack(++from, end, response)) {
 			return HandleResult::RestartConnection;
 		}
-		return handleOneReceived(response.data(), response.data() + response.size(), msgId, info);
+		const auto result = handleOneReceived(
+			response.data(),
+			response.data() + response.size(),
+			msgId,
+			info);
+		if (response.capacity() <= kMaxPooledUnpackedSize) {
+			response.resize(0);
+			_unpackedPool = std::move(response);
+		}
+		return result;
 	}
 
 	case mtpc_msg_container: {
@@ -2008,55 +2111,8 @@ SessionPrivate::HandleResult SessionPrivate::handleBindResponse(
 }
 
 mtpBuffer SessionPrivate::ungzip(const mtpPrime *from, const mtpPrime *end) const {
-	mtpBuffer result; // * 4 because of mtpPrime type
-	result.resize(0);
-
-	MTPstring packed;
-	if (!packed.read(from, end)) { // read packed string as serialized mtp string type
-		LOG(("RPC Error: could not read gziped bytes."));
-		return result;
-	}
-	uint32 packedLen = packed.v.size(), unpackedChunk = packedLen;
-
-	z_stream stream;
-	stream.zalloc = 0;
-	stream.zfree = 0;
-	stream.opaque = 0;
-	stream.avail_in = 0;
-	stream.next_in = 0;
-	int res = inflateInit2(&stream, 16 + MAX_WBITS);
-	if (res != Z_OK) {
-		LOG(("RPC Error: could not init zlib stream, code: %1").arg(res));
-		return result;
-	}
-	stream.avail_in = packedLen;
-	stream.next_in = reinterpret_cast<Bytef*>(packed.v.data());
-
-	stream.avail_out = 0;
-	while (!stream.avail_out) {
-		result.resize(result.size() + unpackedChunk);
-		stream.avail_out = unpackedChunk * sizeof(mtpPrime);
-		stream.next_out = (Bytef*)&result[result.size() - unpackedChunk];
-		int res = inflate(&stream, Z_NO_FLUSH);
-		if (res != Z_OK && res != Z_STREAM_END) {
-			inflateEnd(&stream);
-			LOG(("RPC Error: could not unpack gziped data, code: %1").arg(res));
-			DEBUG_LOG(("RPC Error: bad gzip: %1").arg(Logs::mb(packed.v.constData(), packedLen).str()));
-			return mtpBuffer();
-		}
-	}
-	if (stream.avail_out & 0x03) {
-		uint32 badSize = result.size() * sizeof(mtpPrime) - stream.avail_out;
-		LOG(("RPC Error: bad length of unpacked data %1").arg(badSize));
-		DEBUG_LOG(("RPC Error: bad unpacked data %1").arg(Logs::mb(result.data(), badSize).str()));
-		return mtpBuffer();
-	}
-	result.resize(result.size() - (stream.avail_out >> 2));
-	inflateEnd(&stream);
-	if (!result.size()) {
-		LOG(("RPC Error: bad length of unpacked data 0"));
-	}
-	return result;
+	auto result = mtpBuffer();
+	return GzipUnpack(from, end, result) ? result : mtpBuffer();
 }
 
 bool SessionPrivate::requestsFixTimeSalt(const QVector<MTPlong> &ids, const OuterInfo &info) {
@@ -2322,6 +2378,7 @@ void SessionPrivate::onConnected(
 		_waitForBetterTimer.callOnce(kWaitForBetterTimeout);
 	} else {
 		DEBUG_LOG(("MTP Info: connection through IPv4 succeed."));
+		Tracing::Instant("MTP connected", _shiftedDcId);
 		_waitForBetterTimer.cancel();
 		_connection = std::move(i->data);
 		_testConnections.clear();
@@ -2358,6 +2415,7 @@ void SessionPrivate::confirmBestConnection() {
 
 	DEBUG_LOG(("MTP Info: can't connect through better, using %1."
 		).arg(i->data->tag()));
+	Tracing::Instant("MTP connected", _shiftedDcId);
 
 	_connection = std::move(i->data);
 	_testConnections.clear();
@@ -2574,6 +2632,8 @@ DcType SessionPrivate::tryAcquireKeyCreation() {
 }
 
 void SessionPrivate::authKeyChecked() {
+	Tracing::Instant("MTP auth key checked", _shiftedDcId);
+
 	connect(_connection, &AbstractConnection::receivedData, [=] {
 		handleReceived();
 	});
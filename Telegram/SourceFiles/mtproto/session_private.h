@@ -61,6 +61,12 @@ private:
 		crl::time sent = 0;
 		std::vector<mtpMsgId> messages;
 	};
+	struct SendStats {
+		crl::time since = 0;
+		int writes = 0;
+		int containers = 0;
+		int64 containersSize = 0;
+	};
 	enum class HandleResult {
 		Success,
 		Ignored,
@@ -101,6 +107,9 @@ private:
 	void checkSentRequests();
 	void clearOldContainers();
 
+	[[nodiscard]] bool holdForCoalescing();
+	void accumulateSendStats(int size, bool container);
+
 	mtpMsgId placeToContainer(
 		SerializedRequest &toSendRequest,
 		mtpMsgId &bigMsgId,
@@ -215,6 +224,8 @@ private:
 	base::Timer _pingSender;
 	base::Timer _checkSentRequestsTimer;
 	base::Timer _clearOldContainersTimer;
+	base::Timer _coalesceTimer;
+	SendStats _sendStats;
 
 	std::shared_ptr<SessionData> _sessionData;
 	std::unique_ptr<SessionOptions> _options;
@@ -233,6 +244,7 @@ private:
 	base::flat_map<mtpMsgId, mtpRequestId> _ackedIds;
 	base::flat_map<mtpMsgId, SerializedRequest> _stateAndResendRequests;
 	base::flat_map<mtpMsgId, SentContainer> _sentContainers;
+	mtpBuffer _unpackedPool;
 
 	std::unique_ptr<BoundKeyCreator> _keyCreator;
 	mtpMsgId _bindMsgId = 0;
@@ -39,6 +39,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "tray.h"
 #include "storage/localstorage.h"
 #include "storage/storage_domain.h"
+#include "data/components/memory_manager.h"
 #include "data/data_session.h"
 #include "main/main_account.h"
 #include "main/main_domain.h"
@@ -933,11 +934,66 @@ void SetupOpenGL(
 	}, container->lifetime());
 }
 
+void SetupChatsMemoryBudget(
+		not_null<Window::SessionController*> controller,
+		not_null<Ui::VerticalLayout*> container) {
+	const auto budgets = std::vector<int>{ 0, 128, 256, 512, 1024 };
+	const auto options = ranges::views::all(
+		budgets
+	) | ranges::views::transform([](int budget) {
+		return budget
+			? Ui::FormatSizeText(int64(budget) * 1024 * 1024)
+			: tr::lng_settings_memory_budget_unlimited(tr::now);
+	}) | ranges::to_vector;
+	const auto current = container->lifetime().make_state<
+		rpl::variable<int>
+	>(Core::App().settings().chatsMemoryBudget());
+	const auto indexOf = [=](int budget) {
+		const auto i = ranges::find(budgets, budget);
+		return (i != end(budgets)) ? int(i - begin(budgets)) : 0;
+	};
+	const auto button = AddButtonWithLabel(
+		container,
+		tr::lng_settings_memory_budget(),
+		current->value() | rpl::map([=](int budget) {
+			return options[indexOf(budget)];
+		}),
+		st::settingsButtonNoIcon);
+	button->addClickHandler([=] {
+		controller->show(Box([=](not_null<Ui::GenericBox*> box) {
+			const auto save = [=](int index) {
+				const auto budget = budgets[index];
+				if (budget != current->current()) {
+					Core::App().settings().setChatsMemoryBudget(budget);
+					Core::App().saveSettingsDelayed();
+					*current = budget;
+				}
+			};
+			SingleChoiceBox(box, {
+				.title = tr::lng_settings_memory_budget(),
+				.options = options,
+				.initialSelection = indexOf(current->current()),
+				.callback = save,
+			});
+			const auto usage = controller->session().memoryManager().usage();
+			box->addRow(object_ptr<Ui::FlatLabel>(
+				box,
+				tr::lng_settings_memory_budget_about(
+					lt_size,
+					rpl::single(Ui::FormatSizeText(usage.bytes)),
+					lt_chats,
+					rpl::single(QString::number(usage.histories))),
+				st::boxDividerLabel));
+		}));
+	});
+}
+
 void SetupPerformance(
 		not_null<Window::SessionController*> controller,
 		not_null<Ui::VerticalLayout*> container) {
 	SetupAnimations(&controller->window(), container);
 	SetupHardwareAcceleration(container);
+	SetupChatsMemoryBudget(controller, container);
 #ifdef DESKTOP_APP_USE_ANGLE
 	SetupANGLE(controller, container);
 #else // DESKTOP_APP_USE_ANGLE
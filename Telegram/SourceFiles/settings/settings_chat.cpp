@@ -1166,6 +1166,20 @@ void SetupDataStorage(
 	path->toggleOn(ask->toggledValue() | rpl::map(!_1));
 #endif // OS_WIN_STORE
 
+	const auto messages = container->add(object_ptr<Ui::SettingsButton>(
+		container,
+		tr::lng_settings_local_messages_cache(),
+		st::settingsButtonNoIcon
+	))->toggleOn(rpl::single(Core::App().settings().localMessagesCache()));
+
+	messages->toggledValue(
+	) | rpl::filter([](bool checked) {
+		return (checked != Core::App().settings().localMessagesCache());
+	}) | rpl::start_with_next([=](bool checked) {
+		Core::App().settings().setLocalMessagesCache(checked);
+		Core::App().saveSettingsDelayed();
+	}, messages->lifetime());
+
 	Ui::AddSkip(container, st::settingsCheckboxesSkip);
 }
 
@@ -25,11 +25,19 @@ constexpr auto TdfMagicLen = int(sizeof(TdfMagic));
 
 constexpr auto kStrongIterationsCount = 100'000;
 
+enum class WriteType {
+	File,
+	JournalReset,
+	JournalAppend,
+};
+
 struct WriteEntry {
 	QString basePath;
 	QString base;
 	QByteArray data;
 	QByteArray md5;
+	WriteType type = WriteType::File;
+	Fn<void()> failed;
 };
 
 class WriteManager final {
@@ -45,6 +53,7 @@ private:
 	void writeScheduled();
 	bool writeOneScheduledNow();
 	void writeNow(WriteEntry &&entry);
+	void writeJournalNow(WriteEntry &&entry);
 
 	template <typename File>
 	[[nodiscard]] bool open(File &file, const WriteEntry &entry, char postfix);
@@ -77,17 +86,39 @@ WriteManager::WriteManager(crl::weak_on_thread<WriteManager> weak)
 }
 
 void WriteManager::write(WriteEntry &&entry) {
-	const auto i = ranges::find(_scheduled, entry.base, &WriteEntry::base);
-	if (i == end(_scheduled)) {
+	if (entry.type == WriteType::JournalAppend) {
+		_scheduled.push_back(std::move(entry));
+	} else if (entry.type == WriteType::JournalReset) {
+		// Records appended before the reset are not needed anymore.
+		_scheduled.erase(ranges::remove_if(_scheduled, [&](
+				const WriteEntry &scheduled) {
+			return (scheduled.base == entry.base)
+				&& (scheduled.type != WriteType::File);
+		}), end(_scheduled));
 		_scheduled.push_back(std::move(entry));
 	} else {
-		*i = std::move(entry);
+		const auto i = ranges::find_if(_scheduled, [&](
+				const WriteEntry &scheduled) {
+			return (scheduled.base == entry.base)
+				&& (scheduled.type == WriteType::File);
+		});
+		if (i == end(_scheduled)) {
+			_scheduled.push_back(std::move(entry));
+		} else {
+			*i = std::move(entry);
+		}
 	}
 	scheduleWrite();
 }
 
 void WriteManager::writeSync(WriteEntry &&entry) {
-	const auto i = ranges::find(_scheduled, entry.base, &WriteEntry::base);
+	Expects(entry.type == WriteType::File);
+
+	const auto i = ranges::find_if(_scheduled, [&](
+			const WriteEntry &scheduled) {
+		return (scheduled.base == entry.base)
+			&& (scheduled.type == WriteType::File);
+	});
 	if (i != end(_scheduled)) {
 		_scheduled.erase(i);
 	}
@@ -95,6 +126,10 @@ void WriteManager::writeSync(WriteEntry &&entry) {
 }
 
 void WriteManager::writeNow(WriteEntry &&entry) {
+	if (entry.type != WriteType::File) {
+		writeJournalNow(std::move(entry));
+		return;
+	}
 	const auto path = [&](char postfix) {
 		return this->path(entry, postfix);
 	};
@@ -135,6 +170,42 @@ void WriteManager::writeNow(WriteEntry &&entry) {
 	}
 }
 
+void WriteManager::writeJournalNow(WriteEntry &&entry) {
+	auto file = QFile(path(entry, 'j'));
+	if (entry.type == WriteType::JournalReset) {
+		if (open(file, entry, 'j')
+			&& file.write(entry.data) == entry.data.size()) {
+			base::Platform::FlushFileData(file);
+		} else {
+			// Don't let records be appended to the old generation.
+			file.close();
+			QFile::remove(file.fileName());
+		}
+		return;
+	}
+	const auto failed = [&] {
+		if (entry.failed) {
+			entry.failed();
+		}
+	};
+	if (!file.exists()) {
+		// The key was cleared or the reset failed.
+		failed();
+		return;
+	} else if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+		LOG(("Storage Error: Could not open '%1' for appending."
+			).arg(file.fileName()));
+		failed();
+		return;
+	} else if (file.write(entry.data) != entry.data.size()) {
+		LOG(("Storage Error: Could not append to '%1'."
+			).arg(file.fileName()));
+		failed();
+		return;
+	}
+	base::Platform::FlushFileData(file);
+}
+
 void WriteManager::writeSyncAll() {
 	while (writeOneScheduledNow()) {
 	}
@@ -288,6 +359,8 @@ void ClearKey(const FileKey &key, const QString &basePath) {
 	QFile::remove(name);
 	name[name.size() - 1] = 's';
 	QFile::remove(name);
+	name[name.size() - 1] = 'j';
+	QFile::remove(name);
 }
 
 bool CheckStreamStatus(QDataStream &stream) {
@@ -665,6 +738,89 @@ bool ReadEncryptedFile(
 	return ReadEncryptedFile(result, ToFilePart(fkey), basePath, key);
 }
 
+void AppendJournal(
+		const FileKey &key,
+		const QString &basePath,
+		EncryptedDescriptor &data,
+		const MTP::AuthKeyPtr &localKey,
+		Fn<void()> failed) {
+	auto record = QByteArray();
+	{
+		auto stream = QDataStream(&record, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_5_1);
+		stream << PrepareEncrypted(data, localKey);
+	}
+	Manager.write({
+		.basePath = basePath,
+		.base = basePath + ToFilePart(key),
+		.data = std::move(record),
+		.type = WriteType::JournalAppend,
+		.failed = std::move(failed),
+	});
+}
+
+void ResetJournal(
+		const FileKey &key,
+		const QString &basePath,
+		quint64 generation) {
+	auto header = QByteArray();
+	{
+		auto stream = QDataStream(&header, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_5_1);
+		stream << generation;
+	}
+	Manager.write({
+		.basePath = basePath,
+		.base = basePath + ToFilePart(key),
+		.data = std::move(header),
+		.type = WriteType::JournalReset,
+	});
+}
+
+JournalRecords ReadJournal(
+		const FileKey &key,
+		const QString &basePath,
+		const MTP::AuthKeyPtr &localKey) {
+	auto file = QFile(basePath + ToFilePart(key) + 'j');
+	if (!file.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	char magic[TdfMagicLen];
+	qint32 version = 0;
+	if (file.read(magic, TdfMagicLen) != TdfMagicLen
+		|| memcmp(magic, TdfMagic, TdfMagicLen)
+		|| file.read((char*)&version, sizeof(version)) != sizeof(version)) {
+		LOG(("App Error: bad journal header in '%1'.").arg(file.fileName()));
+		return {};
+	}
+	const auto bytes = file.readAll();
+	auto stream = QDataStream(bytes);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	auto result = JournalRecords{ .complete = true };
+	stream >> result.generation;
+	if (stream.status() != QDataStream::Ok) {
+		LOG(("App Error: bad journal header in '%1'.").arg(file.fileName()));
+		return {};
+	}
+	while (!stream.atEnd()) {
+		auto encrypted = QByteArray();
+		stream >> encrypted;
+		auto data = EncryptedDescriptor();
+		if (stream.status() != QDataStream::Ok
+			|| !DecryptLocal(data, encrypted, localKey)) {
+			// The last record could be written partially.
+			LOG(("App Info: journal '%1' truncated at %2 records."
+				).arg(file.fileName()
+				).arg(result.list.size()));
+			result.complete = false;
+			break;
+		}
+		result.list.push_back(data.data.mid(sizeof(uint32)));
+	}
+	return result;
+}
+
 void Sync() {
 	Manager.sync();
 }
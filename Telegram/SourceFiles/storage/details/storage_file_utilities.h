@@ -106,6 +106,37 @@ bool ReadEncryptedFile(
 	const QString &basePath,
 	const MTP::AuthKeyPtr &key);
 
+// A journal is a file of separately encrypted records next to a key file.
+// Small updates are appended to it instead of rewriting the whole file,
+// the owner resets it each time the key file is written completely.
+// The journal header holds the generation of that key file write, so
+// records left from an older generation can be recognized and skipped.
+// If a record could not be appended, 'failed' is called on the writer
+// thread and the owner should write the key file completely again.
+void AppendJournal(
+	const FileKey &key,
+	const QString &basePath,
+	EncryptedDescriptor &data,
+	const MTP::AuthKeyPtr &localKey,
+	Fn<void()> failed);
+void ResetJournal(
+	const FileKey &key,
+	const QString &basePath,
+	quint64 generation);
+
+struct JournalRecords {
+	std::vector<QByteArray> list;
+	quint64 generation = 0;
+
+	// False if there is no journal or its last record was cut off,
+	// new records can't be appended to it before it is reset.
+	bool complete = false;
+};
+[[nodiscard]] JournalRecords ReadJournal(
+	const FileKey &key,
+	const QString &basePath,
+	const MTP::AuthKeyPtr &localKey);
+
 void Sync();
 void Finish();
 
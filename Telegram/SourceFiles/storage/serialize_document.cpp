@@ -74,11 +74,10 @@ void Document::writeToStream(QDataStream &stream, DocumentData *document) {
 		<< document->inlineThumbnailBytes();
 }
 
-DocumentData *Document::readFromStreamHelper(
-		not_null<Main::Session*> session,
+auto Document::readFieldsHelper(
 		int streamAppVersion,
 		QDataStream &stream,
-		const StickerSetInfo *info) {
+		const StickerSetInfo *info) -> std::optional<Fields> {
 	quint64 id, access;
 	QString name, mime;
 	qint32 date, dc, size, width, height, type, versionTag, version = 0;
@@ -152,7 +151,7 @@ DocumentData *Document::readFromStreamHelper(
 				if (version < 5) {
 					// We didn't store useTextColor yet, can't use.
 					stream.setStatus(QDataStream::ReadCorruptData);
-					return nullptr;
+					return std::nullopt;
 				}
 				using Flag = MTPDdocumentAttributeCustomEmoji::Flag;
 				attributes.push_back(MTP_documentAttributeCustomEmoji(
@@ -221,7 +220,7 @@ DocumentData *Document::readFromStreamHelper(
 		|| !thumb
 		|| !videoThumb) {
 		stream.setStatus(QDataStream::ReadCorruptData);
-		return nullptr;
+		return std::nullopt;
 	}
 	const auto storage = std::get_if<StorageFileLocation>(
 		&thumb->file().data);
@@ -230,30 +229,65 @@ DocumentData *Document::readFromStreamHelper(
 		stream.setStatus(QDataStream::ReadCorruptData);
 		// We can't convert legacy thumbnail location to modern, because
 		// size letter ('s' or 'm') is lost, it was not saved in legacy.
-		return nullptr;
+		return std::nullopt;
 	}
-	return session->data().document(
-		id,
-		access,
-		fileReference,
-		date,
-		attributes,
-		mime,
-		InlineImageLocation{
+	return Fields{
+		.id = id,
+		.access = access,
+		.fileReference = fileReference,
+		.date = date,
+		.attributes = std::move(attributes),
+		.mime = mime,
+		.inlineThumbnail = InlineImageLocation{
 			inlineThumbnailBytes,
 			(inlineThumbnailIsPath == 1),
 		},
-		ImageWithLocation{
+		.thumbnail = ImageWithLocation{
 			.location = *thumb,
 			.bytesCount = thumbnailByteSize
 		},
-		ImageWithLocation{
+		.videoThumbnail = ImageWithLocation{
 			.location = *videoThumb,
 			.bytesCount = videoThumbnailByteSize
 		},
-		(isPremiumSticker == 1),
-		dc,
-		int64(uint32(size)));
+		.isPremiumSticker = (isPremiumSticker == 1),
+		.dc = dc,
+		.size = int64(uint32(size)),
+	};
+}
+
+DocumentData *Document::readFromStreamHelper(
+		not_null<Main::Session*> session,
+		int streamAppVersion,
+		QDataStream &stream,
+		const StickerSetInfo *info) {
+	auto fields = readFieldsHelper(streamAppVersion, stream, info);
+	return fields ? create(session, std::move(*fields)).get() : nullptr;
+}
+
+auto Document::readStickerFields(
+		int streamAppVersion,
+		QDataStream &stream,
+		const StickerSetInfo &info) -> std::optional<Fields> {
+	return readFieldsHelper(streamAppVersion, stream, &info);
+}
+
+not_null<DocumentData*> Document::create(
+		not_null<Main::Session*> session,
+		Fields &&fields) {
+	return session->data().document(
+		fields.id,
+		fields.access,
+		fields.fileReference,
+		fields.date,
+		fields.attributes,
+		fields.mime,
+		fields.inlineThumbnail,
+		fields.thumbnail,
+		fields.videoThumbnail,
+		fields.isPremiumSticker,
+		fields.dc,
+		fields.size);
 }
 
 DocumentData *Document::readStickerFromStream(
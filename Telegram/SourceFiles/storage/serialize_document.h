@@ -24,7 +24,30 @@ public:
 		QString shortName;
 	};
 
+	// Everything needed to create a DocumentData, can be read on any thread.
+	struct Fields {
+		DocumentId id = 0;
+		uint64 access = 0;
+		QByteArray fileReference;
+		TimeId date = 0;
+		QVector<MTPDocumentAttribute> attributes;
+		QString mime;
+		InlineImageLocation inlineThumbnail;
+		ImageWithLocation thumbnail;
+		ImageWithLocation videoThumbnail;
+		bool isPremiumSticker = false;
+		int32 dc = 0;
+		int64 size = 0;
+	};
+
 	static void writeToStream(QDataStream &stream, DocumentData *document);
+	[[nodiscard]] static std::optional<Fields> readStickerFields(
+		int streamAppVersion,
+		QDataStream &stream,
+		const StickerSetInfo &info);
+	static not_null<DocumentData*> create(
+		not_null<Main::Session*> session,
+		Fields &&fields);
 	static DocumentData *readStickerFromStream(
 		not_null<Main::Session*> session,
 		int streamAppVersion,
@@ -37,6 +60,10 @@ public:
 	static int sizeInStream(DocumentData *document);
 
 private:
+	static std::optional<Fields> readFieldsHelper(
+		int streamAppVersion,
+		QDataStream &stream,
+		const StickerSetInfo *info);
 	static DocumentData *readFromStreamHelper(
 		not_null<Main::Session*> session,
 		int streamAppVersion,
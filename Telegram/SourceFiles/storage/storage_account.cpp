@@ -28,6 +28,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/application.h"
 #include "core/core_settings.h"
 #include "core/file_location.h"
+#include "core/tracing.h"
 #include "data/components/recent_peers.h"
 #include "data/components/top_peers.h"
 #include "data/stickers/data_stickers.h"
@@ -46,6 +47,7 @@ using namespace details;
 using Database = Cache::Database;
 
 constexpr auto kDelayedWriteTimeout = crl::time(1000);
+constexpr auto kLocationsJournalMinSize = 64 * 1024;
 constexpr auto kWriteSearchSuggestionsDelay = 5 * crl::time(1000);
 
 constexpr auto kStickersVersionTag = quint32(-1);
@@ -253,6 +255,9 @@ base::flat_set<QString> Account::collectGoodNames() const {
 Account::ReadMapResult Account::readMapWith(
 		MTP::AuthKeyPtr localKey,
 		const QByteArray &legacyPasscode) {
+	const auto span = Tracing::Span(
+		"Storage::Account::readMapWith",
+		_owner->index());
 	auto ms = crl::now();
 
 	FileReadDescriptor mapData;
@@ -673,6 +678,10 @@ void Account::reset() {
 	_fileLocations.clear();
 	_fileLocationPairs.clear();
 	_fileLocationAliases.clear();
+	_locationsChangedKeys.clear();
+	_locationsChangedAliases.clear();
+	_locationsJournalSize = _locationsSnapshotSize = 0;
+	_locationsJournalReady = false;
 	_downloadsSerialize = nullptr;
 	_downloadsSerialized = QByteArray();
 	_cacheTotalSizeLimit = Database::Settings().totalSizeLimit;
@@ -728,9 +737,11 @@ void Account::writeLocations() {
 	}
 	_locationsChanged = false;
 
+	auto snapshot = false;
 	if (_downloadsSerialize) {
 		if (auto serialized = _downloadsSerialize()) {
 			_downloadsSerialized = std::move(*serialized);
+			snapshot = true;
 		}
 	}
 	if (_fileLocations.isEmpty() && _downloadsSerialized.isEmpty()) {
@@ -739,10 +750,18 @@ void Account::writeLocations() {
 			_locationsKey = 0;
 			writeMapDelayed();
 		}
+		_locationsChangedKeys.clear();
+		_locationsChangedAliases.clear();
+		_locationsJournalSize = _locationsSnapshotSize = 0;
+		_locationsJournalReady = false;
 	} else {
 		if (!_locationsKey) {
 			_locationsKey = GenerateKey(_basePath);
 			writeMapQueued();
+			snapshot = true;
+		}
+		if (!snapshot && _locationsJournalReady && writeLocationsJournal()) {
+			return;
 		}
 		quint32 size = 0;
 		for (auto i = _fileLocations.cbegin(), e = _fileLocations.cend(); i != e; ++i) {
@@ -771,6 +790,9 @@ void Account::writeLocations() {
 
 		size += sizeof(quint32); // legacy webLocationsCount
 		size += Serialize::bytearraySize(_downloadsSerialized);
+		size += sizeof(quint64); // generation
+
+		++_locationsGeneration;
 
 		EncryptedDescriptor data(size);
 		auto legacyTypeField = 0;
@@ -793,11 +815,138 @@ void Account::writeLocations() {
 			data.stream << quint64(i.key().first) << quint64(i.key().second) << quint64(i.value().first) << quint64(i.value().second);
 		}
 
-		data.stream << quint32(0) << _downloadsSerialized;
+		data.stream
+			<< quint32(0)
+			<< _downloadsSerialized
+			<< _locationsGeneration;
 
 		FileWriteDescriptor file(_locationsKey, _basePath);
 		file.writeEncrypted(data, _localKey);
+		ResetJournal(_locationsKey, _basePath, _locationsGeneration);
+		_locationsJournalReady = true;
+
+		_locationsChangedKeys.clear();
+		_locationsChangedAliases.clear();
+		_locationsJournalSize = 0;
+		_locationsSnapshotSize = size;
+	}
+}
+
+bool Account::writeLocationsJournal() {
+	if (_locationsChangedKeys.empty() && _locationsChangedAliases.empty()) {
+		return true;
+	}
+	auto size = quint32(2 * sizeof(quint32)); // keys count, aliases count
+	for (const auto &key : _locationsChangedKeys) {
+		// key + count
+		size += sizeof(quint64) * 2 + sizeof(quint32);
+		for (auto i = _fileLocations.constFind(key)
+			; (i != _fileLocations.cend()) && (i.key() == key)
+			; ++i) {
+			// name + bookmark + date + size
+			size += Serialize::stringSize(i.value().name())
+				+ Serialize::bytearraySize(i.value().bookmark())
+				+ Serialize::dateTimeSize()
+				+ sizeof(quint32);
+		}
+	}
+	// alias + location
+	size += quint32(_locationsChangedAliases.size()) * sizeof(quint64) * 4;
+
+	// Compact the journal once it grows larger than the file itself.
+	const auto limit = std::max(
+		int64(kLocationsJournalMinSize),
+		_locationsSnapshotSize);
+	if (_locationsJournalSize + size > limit) {
+		return false;
+	}
+
+	EncryptedDescriptor data(size);
+	data.stream << quint32(_locationsChangedKeys.size());
+	for (const auto &key : _locationsChangedKeys) {
+		data.stream
+			<< quint64(key.first)
+			<< quint64(key.second)
+			<< quint32(_fileLocations.count(key));
+		for (auto i = _fileLocations.constFind(key)
+			; (i != _fileLocations.cend()) && (i.key() == key)
+			; ++i) {
+			data.stream
+				<< i.value().name()
+				<< i.value().bookmark()
+				<< i.value().modified
+				<< quint32(i.value().size);
+		}
+	}
+	data.stream << quint32(_locationsChangedAliases.size());
+	for (const auto &key : _locationsChangedAliases) {
+		const auto location = _fileLocationAliases.value(key);
+		data.stream
+			<< quint64(key.first)
+			<< quint64(key.second)
+			<< quint64(location.first)
+			<< quint64(location.second);
 	}
+	const auto weak = base::make_weak(_owner);
+	AppendJournal(_locationsKey, _basePath, data, _localKey, [=] {
+		crl::on_main(weak, [=] {
+			locationsJournalFailed();
+		});
+	});
+
+	_locationsChangedKeys.clear();
+	_locationsChangedAliases.clear();
+	_locationsJournalSize += size;
+	return true;
+}
+
+bool Account::applyLocationsJournalRecord(const QByteArray &record) {
+	auto stream = QDataStream(record);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	auto keysCount = quint32();
+	stream >> keysCount;
+	for (auto i = quint32(); i != keysCount; ++i) {
+		quint64 first = 0, second = 0;
+		quint32 count = 0;
+		stream >> first >> second >> count;
+		if (!CheckStreamStatus(stream)) {
+			return false;
+		}
+		const auto key = MediaKey(first, second);
+		_fileLocations.remove(key);
+		for (auto j = quint32(); j != count; ++j) {
+			QByteArray bookmark;
+			Core::FileLocation loc;
+			quint32 size = 0;
+			stream >> loc.fname >> bookmark >> loc.modified >> size;
+			if (!CheckStreamStatus(stream)) {
+				return false;
+			}
+			loc.setBookmark(bookmark);
+			loc.size = int64(size);
+			_fileLocations.insert(key, loc);
+		}
+	}
+	auto aliasesCount = quint32();
+	stream >> aliasesCount;
+	for (auto i = quint32(); i != aliasesCount; ++i) {
+		quint64 kfirst, ksecond, vfirst, vsecond;
+		stream >> kfirst >> ksecond >> vfirst >> vsecond;
+		if (!CheckStreamStatus(stream)) {
+			return false;
+		}
+		_fileLocationAliases.insert(
+			MediaKey(kfirst, ksecond),
+			MediaKey(vfirst, vsecond));
+	}
+	return true;
+}
+
+void Account::locationsJournalFailed() {
+	// The appended changes are lost, write all the locations again.
+	_locationsJournalReady = false;
+	writeLocationsQueued();
 }
 
 void Account::writeLocationsQueued() {
@@ -841,12 +990,7 @@ void Account::readLocations() {
 			break;
 		}
 
-		MediaKey key(first, second);
-
-		_fileLocations.insert(key, loc);
-		if (!loc.inMediaCache()) {
-			_fileLocationPairs.insert(loc.fname, { key, loc });
-		}
+		_fileLocations.insert(MediaKey(first, second), loc);
 	}
 
 	if (endMarkFound) {
@@ -872,6 +1016,35 @@ void Account::readLocations() {
 			if (!locations.stream.atEnd()) {
 				locations.stream >> _downloadsSerialized;
 			}
+			if (!locations.stream.atEnd()) {
+				locations.stream >> _locationsGeneration;
+			}
+		}
+	}
+	_locationsSnapshotSize = locations.data.size();
+
+	const auto journal = ReadJournal(_locationsKey, _basePath, _localKey);
+	_locationsJournalReady = journal.complete;
+	if (journal.generation != _locationsGeneration) {
+		// The snapshot was written, but the journal wasn't reset after it.
+		if (!journal.list.empty()) {
+			LOG(("App Info: skipping %1 stale locations journal records."
+				).arg(journal.list.size()));
+		}
+		_locationsJournalReady = false;
+	} else {
+		for (const auto &record : journal.list) {
+			if (!applyLocationsJournalRecord(record)) {
+				LOG(("App Error: bad locations journal record."));
+				_locationsJournalReady = false;
+				break;
+			}
+			_locationsJournalSize += record.size();
+		}
+	}
+	for (auto i = _fileLocations.cbegin(); i != _fileLocations.cend(); ++i) {
+		if (!i.value().inMediaCache()) {
+			_fileLocationPairs.insert(i.value().fname, { i.key(), i.value() });
 		}
 	}
 }
@@ -946,6 +1119,9 @@ ReadSettingsContext Account::prepareReadSettingsContext() const {
 }
 
 std::unique_ptr<Main::SessionSettings> Account::readSessionSettings() {
+	const auto span = Tracing::Span(
+		"Storage::Account::readSessionSettings",
+		_owner->index());
 	ReadSettingsContext context;
 	FileReadDescriptor userSettings;
 	if (!ReadEncryptedFile(userSettings, _settingsKey, _basePath, _localKey)) {
@@ -1619,6 +1795,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 			if (i.value().second == local) {
 				if (i.value().first != location) {
 					_fileLocationAliases.insert(location, i.value().first);
+					_locationsChangedAliases.emplace(location);
 					writeLocationsQueued();
 				}
 				return;
@@ -1630,6 +1807,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 						break;
 					}
 				}
+				_locationsChangedKeys.emplace(i.value().first);
 				_fileLocationPairs.erase(i);
 			}
 		}
@@ -1643,6 +1821,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 		}
 	}
 	_fileLocations.insert(location, local);
+	_locationsChangedKeys.emplace(location);
 	writeLocationsQueued();
 }
 
@@ -1654,6 +1833,7 @@ void Account::removeFileLocation(MediaKey location) {
 	while (i != _fileLocations.end() && (i.key() == location)) {
 		i = _fileLocations.erase(i);
 	}
+	_locationsChangedKeys.emplace(location);
 	writeLocationsQueued();
 }
 
@@ -1667,6 +1847,7 @@ Core::FileLocation Account::readFileLocation(MediaKey location) {
 		if (!i.value().inMediaCache() && !i.value().check()) {
 			_fileLocationPairs.remove(i.value().fname);
 			i = _fileLocations.erase(i);
+			_locationsChangedKeys.emplace(location);
 			writeLocationsDelayed();
 			continue;
 		}
@@ -1797,6 +1978,9 @@ void Account::writeStickerSets(
 		const Data::StickersSetsOrder &order) {
 	using SetFlag = Data::StickersSetFlag;
 
+	if (_readingStickersAtStartup) {
+		_stickerSetsWrittenKeys.emplace(&stickersKey);
+	}
 	const auto &sets = _owner->session().data().stickers().sets();
 	if (sets.empty()) {
 		if (stickersKey) {
@@ -1818,6 +2002,8 @@ void Account::writeStickerSets(
 			return;
 		} else if (result == StickerSetCheckResult::Skip) {
 			continue;
+		} else if (_readingStickersAtStartup) {
+			_stickerSetsWrittenIds.emplace(raw->id);
 		}
 
 		// id
@@ -1893,28 +2079,49 @@ void Account::writeStickerSets(
 	file.writeEncrypted(data, _localKey);
 }
 
-void Account::readStickerSets(
-		FileKey &stickersKey,
-		Data::StickersSetsOrder *outOrder,
-		Data::StickersSetFlags readingFlags) {
-	using SetFlag = Data::StickersSetFlag;
+struct Account::ReadStickerSet {
+	uint64 id = 0;
+	uint64 accessHash = 0;
+	uint64 hash = 0;
+	QString title;
+	QString shortName;
+	int32 count = 0;
+	int32 flags = 0;
+	TimeId installDate = 0;
+	uint64 thumbnailDocumentId = 0;
+	int32 thumbnailType = 0;
+	ImageLocation thumbnail;
+	std::vector<Serialize::Document::Fields> stickers;
+	std::vector<TimeId> dates;
+	std::vector<std::pair<QString, std::vector<DocumentId>>> emoji;
+};
+
+struct Account::ReadStickerSets {
+	std::vector<ReadStickerSet> sets;
+	Data::StickersSetsOrder order;
+	int32 version = 0;
+	bool missing = false;
+	bool failed = false;
+};
+
+auto Account::ReadStickerSetsFile(
+		FileKey stickersKey,
+		const QString &basePath,
+		const MTP::AuthKeyPtr &localKey,
+		bool withOrder) -> ReadStickerSets {
+	auto result = ReadStickerSets();
 
 	FileReadDescriptor stickers;
-	if (!ReadEncryptedFile(stickers, stickersKey, _basePath, _localKey)) {
-		ClearKey(stickersKey, _basePath);
-		stickersKey = 0;
-		writeMapDelayed();
-		return;
+	if (!ReadEncryptedFile(stickers, stickersKey, basePath, localKey)) {
+		result.missing = true;
+		return result;
 	}
 
 	const auto failed = [&] {
-		ClearKey(stickersKey, _basePath);
-		stickersKey = 0;
+		result.failed = true;
+		return std::move(result);
 	};
 
-	auto &sets = _owner->session().data().stickers().setsRef();
-	if (outOrder) outOrder->clear();
-
 	quint32 versionTag = 0;
 	qint32 version = 0;
 	stickers.stream >> versionTag >> version;
@@ -1922,6 +2129,7 @@ void Account::readStickerSets(
 		// Old data, without sticker set thumbnails.
 		return failed();
 	}
+	result.version = version;
 	qint32 count = 0;
 	stickers.stream >> count;
 	if (!CheckStreamStatus(stickers.stream)
@@ -1929,16 +2137,15 @@ void Account::readStickerSets(
 		|| (count > kMaxSavedStickerSetsCount)) {
 		return failed();
 	}
+	result.sets.reserve(count);
 	for (auto i = 0; i != count; ++i) {
 		quint64 setId = 0, setAccessHash = 0, setHash = 0;
 		quint64 setThumbnailDocumentId = 0;
 		QString setTitle, setShortName;
 		qint32 scnt = 0;
 		qint32 setInstallDate = 0;
-		Data::StickersSetFlags setFlags = 0;
 		qint32 setFlagsValue = 0;
 		qint32 setThumbnailType = qint32(StickerType::Webp);
-		ImageLocation setThumbnail;
 
 		stickers.stream
 			>> setId
@@ -1960,6 +2167,18 @@ void Account::readStickerSets(
 		if ((version < 4) && (setFlagsValue & kLegacyFlagWebm)) {
 			setThumbnailType = qint32(StickerType::Webm);
 		}
+		auto set = ReadStickerSet{
+			.id = setId,
+			.accessHash = setAccessHash,
+			.hash = setHash,
+			.title = setTitle,
+			.shortName = setShortName,
+			.count = scnt,
+			.flags = setFlagsValue,
+			.installDate = setInstallDate,
+			.thumbnailDocumentId = setThumbnailDocumentId,
+			.thumbnailType = setThumbnailType,
+		};
 		const auto thumbnail = Serialize::readImageLocation(
 			stickers.version,
 			stickers.stream);
@@ -1969,75 +2188,186 @@ void Account::readStickerSets(
 			// No thumb_version information in legacy location.
 			return failed();
 		} else {
-			setThumbnail = *thumbnail;
+			set.thumbnail = *thumbnail;
+		}
+
+		if (!set.id) {
+			continue;
+		} else if (scnt < 0) { // disabled not loaded set
+			result.sets.push_back(std::move(set));
+			continue;
 		}
 
-		setFlags = Data::StickersSetFlags::from_raw(setFlagsValue);
-		if (setId == Data::Stickers::DefaultSetId) {
+		Serialize::Document::StickerSetInfo info(
+			set.id,
+			set.accessHash,
+			set.shortName);
+		set.stickers.reserve(scnt);
+		for (int32 j = 0; j < scnt; ++j) {
+			auto fields = Serialize::Document::readStickerFields(
+				stickers.version,
+				stickers.stream,
+				info);
+			if (!CheckStreamStatus(stickers.stream)) {
+				return failed();
+			} else if (fields) {
+				set.stickers.push_back(std::move(*fields));
+			}
+		}
+
+		qint32 datesCount = 0;
+		stickers.stream >> datesCount;
+		if (datesCount > 0) {
+			if (datesCount != scnt) {
+				return failed();
+			}
+			set.dates.reserve(datesCount);
+			for (auto i = 0; i != datesCount; ++i) {
+				qint32 date = 0;
+				stickers.stream >> date;
+				set.dates.push_back(TimeId(date));
+			}
+		}
+
+		qint32 emojiCount = 0;
+		stickers.stream >> emojiCount;
+		if (!CheckStreamStatus(stickers.stream) || emojiCount < 0) {
+			return failed();
+		}
+		set.emoji.reserve(emojiCount);
+		for (int32 j = 0; j < emojiCount; ++j) {
+			QString emojiString;
+			qint32 stickersCount;
+			stickers.stream >> emojiString >> stickersCount;
+			auto ids = std::vector<DocumentId>();
+			ids.reserve(std::max(stickersCount, 0));
+			for (int32 k = 0; k < stickersCount; ++k) {
+				quint64 id;
+				stickers.stream >> id;
+				ids.push_back(id);
+			}
+			set.emoji.emplace_back(std::move(emojiString), std::move(ids));
+		}
+		result.sets.push_back(std::move(set));
+	}
+
+	// Read orders of installed and featured stickers.
+	if (withOrder) {
+		auto outOrderCount = quint32();
+		stickers.stream >> outOrderCount;
+		if (!CheckStreamStatus(stickers.stream) || outOrderCount > 1000) {
+			return failed();
+		}
+		result.order.reserve(outOrderCount);
+		for (auto i = 0; i != outOrderCount; ++i) {
+			auto value = uint64();
+			stickers.stream >> value;
+			if (!CheckStreamStatus(stickers.stream)) {
+				result.order.clear();
+				return failed();
+			}
+			result.order.push_back(value);
+		}
+	}
+	if (!CheckStreamStatus(stickers.stream)) {
+		return failed();
+	}
+	return result;
+}
+
+void Account::readStickerSets(
+		FileKey &stickersKey,
+		Data::StickersSetsOrder *outOrder,
+		Data::StickersSetFlags readingFlags) {
+	const auto span = Tracing::Span(
+		"Storage::Account::readStickerSets",
+		_owner->index());
+	applyStickerSets(
+		stickersKey,
+		ReadStickerSetsFile(
+			stickersKey,
+			_basePath,
+			_localKey,
+			(outOrder != nullptr)),
+		outOrder,
+		readingFlags);
+}
+
+void Account::applyStickerSets(
+		FileKey &stickersKey,
+		ReadStickerSets &&parsed,
+		Data::StickersSetsOrder *outOrder,
+		Data::StickersSetFlags readingFlags) {
+	using SetFlag = Data::StickersSetFlag;
+
+	if (parsed.missing) {
+		ClearKey(stickersKey, _basePath);
+		stickersKey = 0;
+		writeMapDelayed();
+		return;
+	}
+
+	const auto session = &_owner->session();
+	auto &sets = session->data().stickers().setsRef();
+	if (outOrder) outOrder->clear();
+
+	for (auto &fields : parsed.sets) {
+		auto setTitle = fields.title;
+		auto setFlags = Data::StickersSetFlags::from_raw(fields.flags);
+		if (fields.id == Data::Stickers::DefaultSetId) {
 			setTitle = tr::lng_stickers_default_set(tr::now);
 			setFlags |= SetFlag::Official | SetFlag::Special;
-		} else if (setId == Data::Stickers::CustomSetId) {
+		} else if (fields.id == Data::Stickers::CustomSetId) {
 			setTitle = u"Custom stickers"_q;
 			setFlags |= SetFlag::Special;
-		} else if ((setId == Data::Stickers::CloudRecentSetId)
-				|| (setId == Data::Stickers::CloudRecentAttachedSetId)) {
+		} else if ((fields.id == Data::Stickers::CloudRecentSetId)
+				|| (fields.id == Data::Stickers::CloudRecentAttachedSetId)) {
 			setTitle = tr::lng_recent_stickers(tr::now);
 			setFlags |= SetFlag::Special;
-		} else if (setId == Data::Stickers::FavedSetId) {
+		} else if (fields.id == Data::Stickers::FavedSetId) {
 			setTitle = Lang::Hard::FavedSetTitle();
 			setFlags |= SetFlag::Special;
-		} else if (!setId) {
-			continue;
 		}
 
-		auto it = sets.find(setId);
+		auto it = sets.find(fields.id);
 		auto settingSet = (it == sets.cend());
 		if (settingSet) {
 			// We will set this flags from order lists when reading those stickers.
 			setFlags &= ~(SetFlag::Installed | SetFlag::Featured);
-			it = sets.emplace(setId, std::make_unique<Data::StickersSet>(
-				&_owner->session().data(),
-				setId,
-				setAccessHash,
-				setHash,
+			it = sets.emplace(fields.id, std::make_unique<Data::StickersSet>(
+				&session->data(),
+				fields.id,
+				fields.accessHash,
+				fields.hash,
 				setTitle,
-				setShortName,
+				fields.shortName,
 				0,
 				setFlags,
-				setInstallDate)).first;
-			it->second->thumbnailDocumentId = setThumbnailDocumentId;
+				fields.installDate)).first;
+			it->second->thumbnailDocumentId = fields.thumbnailDocumentId;
 		}
 		const auto set = it->second.get();
 		const auto inputSet = set->identifier();
 		const auto fillStickers = set->stickers.isEmpty();
 
-		if (scnt < 0) { // disabled not loaded set
+		if (fields.count < 0) { // disabled not loaded set
 			if (!set->count || fillStickers) {
-				set->count = -scnt;
+				set->count = -fields.count;
 			}
 			continue;
 		}
 
 		if (fillStickers) {
-			set->stickers.reserve(scnt);
+			set->stickers.reserve(int(fields.stickers.size()));
 			set->count = 0;
 		}
 
-		Serialize::Document::StickerSetInfo info(
-			setId,
-			setAccessHash,
-			setShortName);
 		base::flat_set<DocumentId> read;
-		for (int32 j = 0; j < scnt; ++j) {
-			auto document = Serialize::Document::readStickerFromStream(
-				&_owner->session(),
-				stickers.version,
-				stickers.stream, info);
-			if (!CheckStreamStatus(stickers.stream)) {
-				return failed();
-			} else if (!document
-				|| !document->sticker()
-				|| read.contains(document->id)) {
+		for (auto &sticker : fields.stickers) {
+			const auto document = Serialize::Document::create(
+				session,
+				std::move(sticker));
+			if (!document->sticker() || read.contains(document->id)) {
 				continue;
 			}
 			read.emplace(document->id);
@@ -2052,44 +2382,20 @@ void Account::readStickerSets(
 			}
 		}
 
-		qint32 datesCount = 0;
-		stickers.stream >> datesCount;
-		if (datesCount > 0) {
-			if (datesCount != scnt) {
-				return failed();
-			}
-			const auto fillDates
-				= ((set->id == Data::Stickers::CloudRecentSetId)
-					|| (set->id == Data::Stickers::CloudRecentAttachedSetId))
-				&& (set->stickers.size() == datesCount);
-			if (fillDates) {
-				set->dates.clear();
-				set->dates.reserve(datesCount);
-			}
-			for (auto i = 0; i != datesCount; ++i) {
-				qint32 date = 0;
-				stickers.stream >> date;
-				if (fillDates) {
-					set->dates.push_back(TimeId(date));
-				}
-			}
+		const auto datesCount = int(fields.dates.size());
+		const auto fillDates = datesCount
+			&& ((set->id == Data::Stickers::CloudRecentSetId)
+				|| (set->id == Data::Stickers::CloudRecentAttachedSetId))
+			&& (set->stickers.size() == datesCount);
+		if (fillDates) {
+			set->dates = std::move(fields.dates);
 		}
 
-		qint32 emojiCount = 0;
-		stickers.stream >> emojiCount;
-		if (!CheckStreamStatus(stickers.stream) || emojiCount < 0) {
-			return failed();
-		}
-		for (int32 j = 0; j < emojiCount; ++j) {
-			QString emojiString;
-			qint32 stickersCount;
-			stickers.stream >> emojiString >> stickersCount;
+		for (const auto &[emojiString, ids] : fields.emoji) {
 			Data::StickersPack pack;
-			pack.reserve(stickersCount);
-			for (int32 k = 0; k < stickersCount; ++k) {
-				quint64 id;
-				stickers.stream >> id;
-				const auto doc = _owner->session().data().document(id);
+			pack.reserve(int(ids.size()));
+			for (const auto id : ids) {
+				const auto doc = session->data().document(id);
 				if (!doc->sticker()) continue;
 
 				pack.push_back(doc);
@@ -2103,7 +2409,8 @@ void Account::readStickerSets(
 		}
 
 		if (settingSet) {
-			if (version < 4
+			auto setThumbnailType = fields.thumbnailType;
+			if (parsed.version < 4
 				&& setThumbnailType == qint32(StickerType::Webp)
 				&& !set->stickers.empty()
 				&& set->stickers.front()->sticker()) {
@@ -2119,30 +2426,20 @@ void Account::readStickerSets(
 				return StickerType::Webp;
 			}();
 			set->setThumbnail(
-				ImageWithLocation{ .location = setThumbnail }, thumbType);
+				ImageWithLocation{ .location = fields.thumbnail },
+				thumbType);
 		}
 	}
 
+	if (parsed.failed) {
+		ClearKey(stickersKey, _basePath);
+		stickersKey = 0;
+		return;
+	}
+
 	// Read orders of installed and featured stickers.
 	if (outOrder) {
-		auto outOrderCount = quint32();
-		stickers.stream >> outOrderCount;
-		if (!CheckStreamStatus(stickers.stream) || outOrderCount > 1000) {
-			return failed();
-		}
-		outOrder->reserve(outOrderCount);
-		for (auto i = 0; i != outOrderCount; ++i) {
-			auto value = uint64();
-			stickers.stream >> value;
-			if (!CheckStreamStatus(stickers.stream)) {
-				outOrder->clear();
-				return failed();
-			}
-			outOrder->push_back(value);
-		}
-	}
-	if (!CheckStreamStatus(stickers.stream)) {
-		return failed();
+		*outOrder = std::move(parsed.order);
 	}
 
 	// Set flags that we dropped above from the order.
@@ -2445,12 +2742,121 @@ void Account::readInstalledStickers() {
 		Data::StickersSetFlag::Installed);
 }
 
+void Account::readStickersAtStartup(Fn<void()> done) {
+	if (!_installedStickersKey) {
+		// Legacy recent stickers are imported synchronously.
+		readInstalledStickers();
+		readInstalledMasks();
+		readInstalledCustomEmoji();
+		readFeaturedStickers();
+		readFeaturedCustomEmoji();
+		readRecentStickers();
+		readRecentMasks();
+		readFavedStickers();
+		done();
+		return;
+	}
+	const auto files = std::vector<std::pair<FileKey, bool>>{
+		{ _installedStickersKey, true },
+		{ _installedMasksKey, true },
+		{ _installedCustomEmojiKey, true },
+		{ _featuredStickersKey, true },
+		{ _featuredCustomEmojiKey, true },
+		{ _recentStickersKey, false },
+		{ _recentMasksKey, false },
+		{ _favedStickersKey, false },
+	};
+	_readingStickersAtStartup = true;
+	_stickerSetsWrittenKeys.clear();
+	_stickerSetsWrittenIds.clear();
+	const auto index = _owner->index();
+	const auto weak = base::make_weak(&_owner->session());
+	crl::async([=, basePath = _basePath, localKey = _localKey] {
+		const auto span = Tracing::Span(
+			"Storage::Account::readStickerSets",
+			index);
+		auto read = std::vector<ReadStickerSets>();
+		read.reserve(files.size());
+		for (const auto &[key, withOrder] : files) {
+			read.push_back(
+				ReadStickerSetsFile(key, basePath, localKey, withOrder));
+		}
+		crl::on_main(weak, [=, read = std::move(read)]() mutable {
+			applyStickersAtStartup(std::move(read));
+			done();
+		});
+	});
+}
+
+void Account::applyStickersAtStartup(std::vector<ReadStickerSets> &&read) {
+	Expects(read.size() == 8);
+
+	const auto span = Tracing::Span(
+		"Storage::Account::applyStickerSets",
+		_owner->index());
+	using SetFlag = Data::StickersSetFlag;
+	auto &stickers = _owner->session().data().stickers();
+
+	// Fresh sets could be received from the server while we were reading,
+	// those and all the files written since then are newer than ours.
+	auto skip = base::take(_stickerSetsWrittenIds);
+	for (const auto &[id, set] : stickers.sets()) {
+		skip.emplace(id);
+	}
+	const auto written = base::take(_stickerSetsWrittenKeys);
+	_readingStickersAtStartup = false;
+
+	auto next = begin(read);
+	const auto apply = [&](
+			FileKey &key,
+			Data::StickersSetsOrder *outOrder = nullptr,
+			Data::StickersSetFlags readingFlags = 0) {
+		auto &parsed = *next++;
+		if (written.contains(&key)) {
+			LOG(("App Info: local sticker sets file is outdated, skipping."));
+			return;
+		}
+		parsed.sets.erase(ranges::remove_if(parsed.sets, [&](
+				const ReadStickerSet &set) {
+			return skip.contains(set.id);
+		}), end(parsed.sets));
+		applyStickerSets(key, std::move(parsed), outOrder, readingFlags);
+	};
+	apply(
+		_installedStickersKey,
+		&stickers.setsOrderRef(),
+		SetFlag::Installed);
+	apply(
+		_installedMasksKey,
+		&stickers.maskSetsOrderRef(),
+		SetFlag::Installed);
+	apply(
+		_installedCustomEmojiKey,
+		&stickers.emojiSetsOrderRef(),
+		SetFlag::Installed);
+	apply(
+		_featuredStickersKey,
+		&stickers.featuredSetsOrderRef(),
+		SetFlag::Featured);
+	apply(
+		_featuredCustomEmojiKey,
+		&stickers.featuredEmojiSetsOrderRef(),
+		SetFlag::Featured);
+	apply(_recentStickersKey);
+	apply(_recentMasksKey);
+	apply(_favedStickersKey);
+	countFeaturedSetsUnread();
+}
+
 void Account::readFeaturedStickers() {
 	readStickerSets(
 		_featuredStickersKey,
 		&_owner->session().data().stickers().featuredSetsOrderRef(),
 		Data::StickersSetFlag::Featured);
+	countFeaturedSetsUnread();
+}
 
+void Account::countFeaturedSetsUnread() {
 	const auto &sets = _owner->session().data().stickers().sets();
 	const auto &order = _owner->session().data().stickers().featuredSetsOrder();
 	int unreadCount = 0;
@@ -141,6 +141,10 @@ public:
 	void readInstalledCustomEmoji();
 	void readFeaturedCustomEmoji();
 
+	// Installed, featured, recent and faved sets are decoded in the
+	// background and applied on the main thread before calling done.
+	void readStickersAtStartup(Fn<void()> done);
+
 	void writeRecentHashtagsAndBots();
 	void readRecentHashtagsAndBots();
 	void saveRecentSentHashtags(const QString &text);
@@ -214,6 +218,9 @@ private:
 
 	void readLocations();
 	void writeLocations();
+	[[nodiscard]] bool writeLocationsJournal();
+	[[nodiscard]] bool applyLocationsJournalRecord(const QByteArray &record);
+	void locationsJournalFailed();
 	void writeLocationsQueued();
 	void writeLocationsDelayed();
 
@@ -245,10 +252,24 @@ private:
 		FileKey &stickersKey,
 		CheckSet checkSet,
 		const Data::StickersSetsOrder &order);
+	struct ReadStickerSet;
+	struct ReadStickerSets;
+	[[nodiscard]] static ReadStickerSets ReadStickerSetsFile(
+		FileKey stickersKey,
+		const QString &basePath,
+		const MTP::AuthKeyPtr &localKey,
+		bool withOrder);
 	void readStickerSets(
 		FileKey &stickersKey,
 		Data::StickersSetsOrder *outOrder = nullptr,
 		Data::StickersSetFlags readingFlags = 0);
+	void applyStickerSets(
+		FileKey &stickersKey,
+		ReadStickerSets &&parsed,
+		Data::StickersSetsOrder *outOrder,
+		Data::StickersSetFlags readingFlags);
+	void applyStickersAtStartup(std::vector<ReadStickerSets> &&read);
+	void countFeaturedSetsUnread();
 	void importOldRecentStickers();
 
 	void readTrustedBots();
@@ -279,6 +300,12 @@ private:
 	QMap<MediaKey, MediaKey> _fileLocationAliases;
 
 	QByteArray _downloadsSerialized;
+	base::flat_set<MediaKey> _locationsChangedKeys;
+	base::flat_set<MediaKey> _locationsChangedAliases;
+	int64 _locationsSnapshotSize = 0;
+	int64 _locationsJournalSize = 0;
+	quint64 _locationsGeneration = 0;
+	bool _locationsJournalReady = false;
 	Fn<std::optional<QByteArray>()> _downloadsSerialize;
 
 	FileKey _locationsKey = 0;
@@ -314,6 +341,11 @@ private:
 	bool _recentHashtagsAndBotsWereRead = false;
 	bool _searchSuggestionsRead = false;
 
+	// Sticker set files and sets written while reading them at startup.
+	bool _readingStickersAtStartup = false;
+	base::flat_set<const FileKey*> _stickerSetsWrittenKeys;
+	base::flat_set<uint64> _stickerSetsWrittenIds;
+
 	Webview::StorageId _webviewStorageIdBots;
 	Webview::StorageId _webviewStorageIdOther;
 
@@ -14,6 +14,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtp_instance.h"
 #include "mtproto/facade.h"
 #include "main/main_account.h"
+#include "main/main_session.h"
+#include "api/api_updates.h"
 #include "core/application.h"
 #include "core/core_settings.h"
 #include "core/update_checker.h"
@@ -208,7 +210,8 @@ bool ConnectionState::State::operator==(const State &other) const {
 		&& (useProxy == other.useProxy)
 		&& (underCursor == other.underCursor)
 		&& (updateReady == other.updateReady)
-		&& (waitTillRetry == other.waitTillRetry);
+		&& (waitTillRetry == other.waitTillRetry)
+		&& (updatingPercent == other.updatingPercent);
 }
 
 ConnectionState::ConnectionState(
@@ -240,6 +243,20 @@ ConnectionState::ConnectionState(
 		}, _lifetime);
 	}
 
+	using Progress = Api::Updates::DifferenceProgress;
+	_account->sessionValue(
+	) | rpl::map([](Main::Session *session) -> rpl::producer<Progress> {
+		if (session) {
+			return session->updates().differenceProgress();
+		}
+		return rpl::single(Progress());
+	}) | rpl::flatten_latest(
+	) | rpl::start_with_next([=](Progress progress) {
+		_differenceProcessed = progress.processed;
+		_differenceTotal = progress.total;
+		refreshState();
+	}, _lifetime);
+
 	rpl::combine(
 		Core::App().settings().proxy().connectionTypeValue(),
 		rpl::single(QRect()) | rpl::then(_parent->paintRequest())
@@ -319,6 +336,19 @@ void ConnectionState::refreshState() {
 		} else if (state < 0) {
 			const auto wait = ((-state) / 1000) + 1;
 			return { State::Type::Waiting, proxy, exposed, under, ready, wait };
+		} else if (_differenceTotal > 0) {
+			const auto percent = int(int64(_differenceProcessed)
+				* 100
+				/ _differenceTotal);
+			return {
+				State::Type::Updating,
+				proxy,
+				exposed,
+				under,
+				ready,
+				0,
+				percent,
+			};
 		}
 		return { State::Type::Connected, proxy, exposed, under, ready };
 	}();
@@ -439,7 +469,8 @@ auto ConnectionState::computeLayout(const State &state) const -> Layout {
 		&& !state.updateReady
 		&& (state.useProxy
 			|| state.type == State::Type::Connecting
-			|| state.type == State::Type::Waiting);
+			|| state.type == State::Type::Waiting
+			|| state.type == State::Type::Updating);
 	switch (state.type) {
 	case State::Type::Connecting:
 		result.text = state.underCursor
@@ -454,6 +485,13 @@ auto ConnectionState::computeLayout(const State &state) const -> Layout {
 			lt_count,
 			state.waitTillRetry);
 		break;
+
+	case State::Type::Updating:
+		result.text = tr::lng_updating_progress(
+			tr::now,
+			lt_percent,
+			QString::number(state.updatingPercent));
+		break;
 	}
 	result.textWidth = st::normalFont->width(result.text);
 	result.contentWidth = (result.textWidth > 0)
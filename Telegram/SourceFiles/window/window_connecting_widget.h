@@ -43,6 +43,7 @@ private:
 			Connected,
 			Connecting,
 			Waiting,
+			Updating,
 		};
 		Type type = Type::Connected;
 		bool useProxy = false;
@@ -50,6 +51,7 @@ private:
 		bool underCursor = false;
 		bool updateReady = false;
 		int waitTillRetry = 0;
+		int updatingPercent = 0;
 
 		bool operator==(const State &other) const;
 
@@ -87,6 +89,8 @@ private:
 	State _state;
 	Layout _currentLayout;
 	crl::time _connectingStartedAt = 0;
+	int _differenceProcessed = 0;
+	int _differenceTotal = 0;
 	Ui::Animations::Simple _contentWidth;
 	Ui::Animations::Simple _visibility;
 